@@ -0,0 +1,97 @@
+/*
+  Measures how long the ZeroTC45 start, stop and restart calls take in each
+  resolution, in CPU clocks.
+
+  The TC registers are synchronised to the TC clock, so the calls that wait for
+  synchronisation take longer the slower the clock is. The Async calls and the
+  retrigger don't wait.
+
+  This example code is in the public domain
+*/
+#include <ZeroTC45.h>
+#include <ZeroTC45Histogram.h>
+
+// All vars are marked as static as they should not be visible outside the scope of this file.
+
+// Create the timer instance.
+static ZeroTC45 timer;
+
+static const uint8_t RUNS = 50;
+
+/**
+ * Call prepare and then call RUNS times, and print a histogram of how long call took.
+ */
+void measure(const char* title, void (*prepare)(), void (*call)(), uint32_t binWidth) {
+    ZeroTC45Histogram cost(0, binWidth);
+
+    for (uint8_t i = 0; i < RUNS; i++) {
+        if (prepare != NULL) {
+            prepare();
+            while (timer.isTc4SyncBusy());
+        }
+
+        uint32_t start = ZeroTC45::getCycles();
+        call();
+        cost.add(ZeroTC45::getCycles() - start);
+
+        // Let any outstanding synchronisation finish so each run starts the same way.
+        while (timer.isTc4SyncBusy());
+        delay(2);
+    }
+
+    cost.print(Serial, title, "clocks");
+}
+
+// Tickless mode uses a different CTRLA, so the next start has to reconfigure TC4 completely.
+void reconfigure() {
+    timer.startTc4Tickless();
+}
+
+void startAgain() {
+    timer.startTc4(500, true);
+}
+
+void startAsync() {
+    timer.startTc4Async(500, true);
+}
+
+void stop() {
+    timer.stopTc4();
+}
+
+void stopAsync() {
+    timer.stopTc4Async();
+}
+
+void retrigger() {
+    timer.retriggerTc4();
+}
+
+void measureResolution(const char* name, ZeroTC45::Resolution resolution, uint32_t binWidth) {
+    timer.begin(resolution);
+
+    Serial.println(name);
+    measure("startTc4 with a new configuration", reconfigure, startAgain, binWidth);
+    measure("startTc4 with the same configuration", NULL, startAgain, binWidth);
+    measure("startTc4Async with the same configuration", NULL, startAsync, binWidth);
+    measure("stopTc4", startAgain, stop, binWidth);
+    measure("stopTc4Async", startAgain, stopAsync, binWidth);
+    measure("retriggerTc4", startAgain, retrigger, binWidth);
+    timer.stopTc4();
+}
+
+void setup() {
+    Serial.begin(115200);
+
+    // Wait for a connection from the serial monitor or a terminal emulator.
+    while ( ! Serial);
+
+    Serial.println("setup done.");
+}
+
+void loop() {
+    measureResolution("MICROSECONDS", ZeroTC45::MICROSECONDS, 50);
+    measureResolution("MILLISECONDS", ZeroTC45::MILLISECONDS, 20000);
+    measureResolution("SECONDS", ZeroTC45::SECONDS, 20000);
+    delay(10000);
+}
@@ -0,0 +1,75 @@
+/*
+  Measures the drift of the ZeroTC45 timers against micros(), in parts per million.
+
+  On the Arduino Zero and similar boards the 48MHz DFLL, and so micros(), is
+  locked to the 32kHz crystal, so this compares each resolution with XOSC32K.
+  MILLISECONDS runs from the less accurate OSCULP32K and shows its error; SECONDS
+  runs from XOSC32K itself and should show next to none.
+
+  This example code is in the public domain
+*/
+#include <ZeroTC45.h>
+#include <ZeroTC45Histogram.h>
+
+// All vars are marked as static as they should not be visible outside the scope of this file.
+
+// Create the timer instance.
+static ZeroTC45 timer;
+
+// -2000 to +1999 ppm in bins of 250.
+static ZeroTC45Histogram drift(-2000, 250);
+
+// Any vars used in the callbacks are marked volatile so the compiler doesn't make assumptions
+// about their values. The callbacks run during interrupts so can change the value asynchronously
+// to the main code path.
+static volatile uint32_t lastMicros = 0;
+static volatile uint32_t nominalMicros = 0;
+static volatile uint32_t samples = 0;
+static volatile boolean first = true;
+
+void tc4Callback() {
+    uint32_t now = micros();
+
+    if ( ! first) {
+        // A timer that runs fast gives intervals shorter than nominal, a positive ppm.
+        int32_t error = (int32_t)(nominalMicros - (now - lastMicros));
+        drift.add((int32_t)((int64_t)error * 1000000 / nominalMicros));
+        samples++;
+    }
+
+    first = false;
+    lastMicros = now;
+}
+
+void measure(const char* title, ZeroTC45::Resolution resolution, uint16_t period, uint32_t count) {
+    timer.begin(resolution);
+
+    uint32_t hz = ZeroTC45::tickHz(timer.getClockConfig());
+    nominalMicros = (uint64_t)period * 1000000 / hz;
+
+    drift.clear();
+    samples = 0;
+    first = true;
+
+    timer.setTc4Callback(tc4Callback);
+    timer.startTc4(period);
+
+    while (samples < count);
+
+    timer.stopTc4();
+    drift.print(Serial, title, "ppm");
+}
+
+void setup() {
+    Serial.begin(115200);
+
+    // Wait for a connection from the serial monitor or a terminal emulator.
+    while ( ! Serial);
+
+    Serial.println("setup done.");
+}
+
+void loop() {
+    measure("MILLISECONDS (OSCULP32K), 1s intervals", ZeroTC45::MILLISECONDS, 1024, 30);
+    measure("SECONDS (XOSC32K), 1s intervals", ZeroTC45::SECONDS, 1, 30);
+}
@@ -0,0 +1,77 @@
+/*
+  Measures the period jitter of the ZeroTC45 library in each resolution: how far
+  each callback is from the previous one plus the nominal period, in CPU clocks.
+
+  MILLISECONDS runs from OSCULP32K, SECONDS from XOSC32K and MICROSECONDS from
+  DFLL48M. The GCLK ticks of the 32kHz sources are 1465 CPU clocks apart, so those
+  resolutions can only be as precise as that.
+
+  This example code is in the public domain
+*/
+#include <ZeroTC45.h>
+#include <ZeroTC45Histogram.h>
+
+// All vars are marked as static as they should not be visible outside the scope of this file.
+
+// Create the timer instance.
+static ZeroTC45 timer;
+
+// -4000 to +3999 clocks in bins of 500.
+static ZeroTC45Histogram jitter(-4000, 500);
+
+// Any vars used in the callbacks are marked volatile so the compiler doesn't make assumptions
+// about their values. The callbacks run during interrupts so can change the value asynchronously
+// to the main code path.
+static volatile uint32_t lastCycles = 0;
+static volatile uint32_t nominalCycles = 0;
+static volatile uint32_t samples = 0;
+static volatile boolean first = true;
+
+void tc4Callback() {
+    uint32_t now = ZeroTC45::getCycles();
+
+    if ( ! first) {
+        jitter.add((int32_t)(now - lastCycles - nominalCycles));
+        samples++;
+    }
+
+    first = false;
+    lastCycles = now;
+}
+
+/**
+ * Run TC4 with the given resolution and period and print the jitter histogram.
+ */
+void measure(const char* title, ZeroTC45::Resolution resolution, uint16_t period, uint32_t count) {
+    timer.begin(resolution);
+
+    uint32_t hz = ZeroTC45::tickHz(timer.getClockConfig());
+    nominalCycles = (uint64_t)period * SystemCoreClock / hz;
+
+    jitter.clear();
+    samples = 0;
+    first = true;
+
+    timer.setTc4Callback(tc4Callback);
+    timer.startTc4(period);
+
+    while (samples < count);
+
+    timer.stopTc4();
+    jitter.print(Serial, title, "clocks");
+}
+
+void setup() {
+    Serial.begin(115200);
+
+    // Wait for a connection from the serial monitor or a terminal emulator.
+    while ( ! Serial);
+
+    Serial.println("setup done.");
+}
+
+void loop() {
+    measure("MICROSECONDS, 1000us period", ZeroTC45::MICROSECONDS, 1000, 5000);
+    measure("MILLISECONDS, 10ms period", ZeroTC45::MILLISECONDS, 10, 500);
+    measure("SECONDS, 1s period", ZeroTC45::SECONDS, 1, 10);
+}
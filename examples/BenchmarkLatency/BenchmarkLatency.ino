@@ -0,0 +1,65 @@
+/*
+  Measures the interrupt latency of the ZeroTC45 library: the time from the TC4
+  overflow to the first line of the callback.
+
+  TC4 is clocked at 48MHz so one tick is one CPU clock, and the callback reads the
+  count, which restarted from zero at the overflow. The count read takes a few clocks
+  to synchronise, which adds a constant to every value. LED_BUILTIN is toggled at the
+  start of each callback for a scope or logic analyser.
+
+  This example code is in the public domain
+*/
+#include <ZeroTC45.h>
+#include <ZeroTC45Histogram.h>
+
+// All vars are marked as static as they should not be visible outside the scope of this file.
+
+// Create the timer instance.
+static ZeroTC45 timer;
+
+// 48MHz ticks, one per CPU clock.
+typedef ZeroTC45TickRate<48000000> CpuClock;
+
+// 0 to 159 clocks in bins of 10.
+static ZeroTC45Histogram latency(0, 10);
+
+static const uint32_t SAMPLES = 10000;
+
+void tc4Callback() {
+    digitalWrite(LED_BUILTIN, ! digitalRead(LED_BUILTIN));
+
+    // Read the count since the overflow.
+    TC4->COUNT16.READREQ.reg = TC_READREQ_RREQ | TC_READREQ_ADDR(TC_COUNT16_COUNT_OFFSET);
+    while (TC4->COUNT16.STATUS.bit.SYNCBUSY);
+    uint16_t count = TC4->COUNT16.COUNT.reg;
+
+    if (latency.count() < SAMPLES) {
+        latency.add(count);
+    }
+}
+
+void setup() {
+    Serial.begin(115200);
+
+    // Wait for a connection from the serial monitor or a terminal emulator.
+    while ( ! Serial);
+
+    pinMode(LED_BUILTIN, OUTPUT);
+
+    timer.begin(CpuClock::config());
+
+    // Interrupt every 48000 clocks, 1000 times a second.
+    timer.setTc4Callback(tc4Callback);
+    timer.startTc4(48000);
+
+    Serial.println("setup done.");
+}
+
+void loop() {
+    if (latency.count() >= SAMPLES) {
+        timer.stopTc4();
+        latency.print(Serial, "TC4 overflow to callback latency", "clocks");
+        latency.clear();
+        timer.startTc4(48000);
+    }
+}
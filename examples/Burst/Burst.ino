@@ -0,0 +1,54 @@
+/*
+  Demonstrates the burst mode of the ZeroTC45 library. Each time 'p' is sent
+  over serial, TC4 polls a device 5 times, 20 milliseconds apart, and then
+  stops by itself. The callback doesn't count the polls or stop the timer.
+
+  This example code is in the public domain
+*/
+#include <ZeroTC45.h>
+
+// All vars are marked as static as they should not be visible outside the scope of this file.
+
+// Create the timer instance.
+static ZeroTC45 timer;
+
+// Any vars used in the callbacks are marked volatile so the compiler doesn't make assumptions
+// about their values. The callbacks run during interrupts so can change the value asynchronously
+// to the main code path.
+static volatile uint32_t polls = 0;
+static volatile uint32_t lastPoll = 0;
+
+void pollCallback() {
+    // Stands in for sending a poll request to a device.
+    polls++;
+    lastPoll = millis();
+}
+
+void setup() {
+    Serial.begin(115200);
+
+    // Wait for a connection from the serial monitor or a terminal emulator.
+    while ( ! Serial);
+
+    timer.begin(ZeroTC45::MILLISECONDS);
+    timer.setTc4Callback(pollCallback);
+
+    Serial.println("setup done, send 'p' to start a burst of polls.");
+}
+
+static char msg[80];
+
+void loop() {
+    static uint32_t reported = 0;
+
+    if (Serial.read() == 'p') {
+        polls = 0;
+        timer.startTc4Burst(20, 5);
+    }
+
+    if (polls != reported) {
+        reported = polls;
+        snprintf(msg, sizeof(msg), "%8lu: poll %lu, %u left", lastPoll, reported, timer.getTc4BurstRemaining());
+        Serial.println(msg);
+    }
+}
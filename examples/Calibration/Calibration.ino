@@ -0,0 +1,69 @@
+/*
+  Demonstrates the ZeroTC45Calibrator of the ZeroTC45 library. The ticks of the
+  timer clock are counted against a 1Hz reference, eg the PPS output of a GPS
+  on pin 2, and the error is used to correct the periods of TC4.
+
+  This example code is in the public domain
+*/
+#include <ZeroTC45.h>
+#include <ZeroTC45Calibrator.h>
+
+// All vars are marked as static as they should not be visible outside the scope of this file.
+
+// The pin the reference is connected to. It must have an external interrupt.
+static const uint8_t REFERENCE_PIN = 2;
+
+// How many reference periods to measure before applying the correction. The
+// 1024Hz ticks of CRYSTAL_MILLISECONDS measure to about 1.6ppm in 10 minutes.
+static const uint32_t CALIBRATION_PERIODS = 600;
+
+// Create the timer instance and the calibrator.
+static ZeroTC45 timer;
+static ZeroTC45Calibrator calibrator(timer);
+
+// Any vars used in the callbacks are marked volatile so the compiler doesn't make assumptions
+// about their values. The callbacks run during interrupts so can change the value asynchronously
+// to the main code path.
+static volatile uint32_t fires = 0;
+
+void tc4Callback() {
+    fires++;
+}
+
+static char msg[80];
+
+void setup() {
+    Serial.begin(115200);
+
+    // Wait for a connection from the serial monitor or a terminal emulator.
+    while ( ! Serial);
+
+    timer.begin(ZeroTC45::CRYSTAL_MILLISECONDS);
+
+    calibrator.begin(REFERENCE_PIN, 1);
+
+    Serial.println("measuring...");
+    uint32_t periods;
+    while ((periods = calibrator.getPeriods()) < CALIBRATION_PERIODS) {
+        snprintf(msg, sizeof(msg), "%lus, error %ldppb", periods, calibrator.getErrorPpb());
+        Serial.println(msg);
+        delay(1000);
+    }
+
+    calibrator.end();
+    calibrator.apply();
+
+    // Call tc4Callback every 1000 milliseconds of corrected time.
+    timer.setTc4Callback(tc4Callback);
+    timer.startTc4(1000);
+
+    snprintf(msg, sizeof(msg), "setup done, correction %ldppb", calibrator.getErrorPpb());
+    Serial.println(msg);
+}
+
+void loop() {
+    delay(10000);
+
+    snprintf(msg, sizeof(msg), "%lu fires", fires);
+    Serial.println(msg);
+}
@@ -0,0 +1,66 @@
+/*
+  Demonstrates the ZeroTC template of the ZeroTC45 library, which fixes the TC
+  and resolution at compile time so it can be started and stopped with a few
+  register writes. Here a button on pin 2 starts a 50 millisecond one-shot
+  from its interrupt handler, which debounces it: the release is only seen
+  once the button has been still for 50 milliseconds.
+
+  This example code is in the public domain
+*/
+#include <ZeroTC45.h>
+#include <ZeroTC.h>
+
+// All vars are marked as static as they should not be visible outside the scope of this file.
+
+// The pin of the button, which connects it to ground.
+static const uint8_t BUTTON_PIN = 2;
+
+// Create the timer instance.
+static ZeroTC45 timer;
+
+// TC4 with 1024Hz ticks.
+typedef ZeroTC<ZeroTC45Tc4, ZeroTC45::MILLISECONDS> Debounce;
+
+// Any vars used in the callbacks are marked volatile so the compiler doesn't make assumptions
+// about their values. The callbacks run during interrupts so can change the value asynchronously
+// to the main code path.
+static volatile uint32_t presses = 0;
+
+void buttonChanged() {
+    // Restart the one-shot on every bounce.
+    Debounce::start();
+}
+
+void tc4Callback() {
+    if (digitalRead(BUTTON_PIN) == LOW) {
+        presses++;
+    }
+}
+
+void setup() {
+    Serial.begin(115200);
+
+    // Wait for a connection from the serial monitor or a terminal emulator.
+    while ( ! Serial);
+
+    timer.begin(ZeroTC45::MILLISECONDS);
+    timer.setTc4Callback(tc4Callback);
+
+    // 51 ticks is about 50 milliseconds. begin starts it once, so stop it until the button is pressed.
+    Debounce::begin(timer, 51, true);
+    Debounce::stop();
+
+    pinMode(BUTTON_PIN, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(BUTTON_PIN), buttonChanged, CHANGE);
+
+    Serial.println("setup done.");
+}
+
+static char msg[80];
+
+void loop() {
+    delay(1000);
+
+    snprintf(msg, sizeof(msg), "%lu presses", presses);
+    Serial.println(msg);
+}
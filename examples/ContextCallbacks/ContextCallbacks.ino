@@ -0,0 +1,63 @@
+/*
+  Demonstrates callbacks with a context pointer and member function callbacks in the
+  ZeroTC45 library, so each timer's state lives in its own object.
+
+  This example code is in the public domain
+*/
+#include <ZeroTC45.h>
+
+// Counts the interrupts of one timer.
+class TickCounter {
+public:
+    TickCounter(const char* name) : name(name), ticks(0) {}
+
+    void tick() {
+        ticks++;
+    }
+
+    const char* name;
+
+    // Marked volatile as it is changed from the interrupt.
+    volatile uint32_t ticks;
+};
+
+// All vars are marked as static as they should not be visible outside the scope of this file.
+
+// Create the timer instance.
+static ZeroTC45 timer;
+
+static TickCounter tc4Counter("TC4");
+static TickCounter tc5Counter("TC5");
+
+// A plain function callback with a context pointer.
+void countTick(void* context) {
+    static_cast<TickCounter*>(context)->tick();
+}
+
+void setup() {
+    Serial.begin(115200);
+
+    // Wait for a connection from the serial monitor or a terminal emulator.
+    while ( ! Serial);
+
+    timer.begin(ZeroTC45::MILLISECONDS);
+
+    // TC4 calls countTick(&tc4Counter) every 100 milliseconds.
+    timer.setTc4Callback(countTick, &tc4Counter);
+    timer.startTc4(100);
+
+    // TC5 calls tc5Counter.tick() every 250 milliseconds.
+    timer.setTc5Callback<TickCounter, &TickCounter::tick>(&tc5Counter);
+    timer.startTc5(250);
+
+    Serial.println("setup done.");
+}
+
+static char msg[64];
+
+void loop() {
+    delay(1000);
+
+    snprintf(msg, sizeof(msg), "%s: %lu, %s: %lu", tc4Counter.name, tc4Counter.ticks, tc5Counter.name, tc5Counter.ticks);
+    Serial.println(msg);
+}
@@ -0,0 +1,57 @@
+/*
+  Demonstrates the CRYSTAL_MILLISECONDS resolution of the ZeroTC45 library. The
+  timer runs from the 32kHz crystal and periods are exact milliseconds on average,
+  so a long running schedule doesn't drift.
+
+  This example code is in the public domain
+*/
+#include <ZeroTC45.h>
+
+// All vars are marked as static as they should not be visible outside the scope of this file.
+
+// Create the timer instance.
+static ZeroTC45 timer;
+
+// Any vars used in the callbacks are marked volatile so the compiler doesn't make assumptions
+// about their values. The callbacks run during interrupts so can change the value asynchronously
+// to the main code path.
+static volatile uint32_t fires = 0;
+static volatile uint32_t firstMicros = 0;
+static volatile uint32_t lastMicros = 0;
+
+void tc4Callback() {
+    lastMicros = micros();
+    if (fires++ == 0) {
+        firstMicros = lastMicros;
+    }
+}
+
+void setup() {
+    Serial.begin(115200);
+
+    // Wait for a connection from the serial monitor or a terminal emulator.
+    while ( ! Serial);
+
+    timer.begin(ZeroTC45::CRYSTAL_MILLISECONDS);
+
+    // Call tc4Callback every 10 milliseconds. That is 10.24 ticks of the 1024Hz
+    // crystal clock, so most periods are 10 ticks and every fourth or so is 11.
+    timer.setTc4Callback(tc4Callback);
+    timer.startTc4(10);
+
+    Serial.println("setup done.");
+}
+
+static char msg[80];
+
+void loop() {
+    delay(5000);
+
+    uint32_t n = fires;
+    if (n > 1) {
+        // The average period over the whole run, in nanoseconds.
+        uint32_t averageNs = (uint64_t)(lastMicros - firstMicros) * 1000 / (n - 1);
+        snprintf(msg, sizeof(msg), "%lu fires, average period %luns", n, averageNs);
+        Serial.println(msg);
+    }
+}
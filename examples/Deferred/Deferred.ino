@@ -0,0 +1,64 @@
+/*
+  Demonstrates the interrupt priorities and deferred callbacks of the ZeroTC45
+  library. TC4 fires every 10 milliseconds with a callback that takes 3
+  milliseconds, which at the default priority would hold up the SERCOM
+  interrupt of Serial1 long enough to lose received characters.
+
+  With the callback deferred, the TC4 interrupt only counts the fire, and the
+  callback runs at the lowest priority where Serial1 can preempt it. Characters
+  sent to Serial1 are echoed back, to show none are lost.
+
+  This example code is in the public domain
+*/
+#include <ZeroTC45.h>
+
+// All vars are marked as static as they should not be visible outside the scope of this file.
+
+// Create the timer instance.
+static ZeroTC45 timer;
+
+// Any vars used in the callbacks are marked volatile so the compiler doesn't make assumptions
+// about their values. The callbacks run during interrupts so can change the value asynchronously
+// to the main code path.
+static volatile uint32_t slowCalls = 0;
+
+void slowCallback() {
+    // Stands in for a long job, eg reading a slow sensor.
+    delayMicroseconds(3000);
+    slowCalls++;
+}
+
+void setup() {
+    Serial1.begin(115200);
+
+    timer.begin(ZeroTC45::MILLISECONDS);
+    timer.setTc4Callback(slowCallback);
+
+    // The TC4 interrupt stays at the highest priority so its timing is tight,
+    // and the callback runs from the deferred interrupt at the lowest.
+    timer.setTc4Priority(0);
+    timer.setTc4Deferred(true);
+    ZeroTC45::setDeferredPriority(3);
+
+    timer.startTc4(10);
+
+    Serial1.println("setup done.");
+}
+
+static char msg[80];
+
+void loop() {
+    static uint32_t lastReport = 0;
+
+    while (Serial1.available()) {
+        Serial1.write(Serial1.read());
+    }
+
+    if (millis() - lastReport >= 5000) {
+        lastReport = millis();
+
+        ZeroTC45::Stats stats = timer.getTc4Stats();
+        snprintf(msg, sizeof(msg), "%8lu: %lu fires, %lu calls, %lu missed", millis(), stats.fires, slowCalls, stats.missed);
+        Serial1.println(msg);
+    }
+}
@@ -0,0 +1,48 @@
+/*
+  Demonstrates starting ADC conversions from TC5 through the event system with the
+  ZeroTC45 library, with no interrupts at all.
+
+  This example code is in the public domain
+*/
+#include <ZeroTC45.h>
+
+// All vars are marked as static as they should not be visible outside the scope of this file.
+
+// Create the timer instance.
+static ZeroTC45 timer;
+
+void setup() {
+    Serial.begin(115200);
+
+    // Wait for a connection from the serial monitor or a terminal emulator.
+    while ( ! Serial);
+
+    // Let the Arduino core set up the ADC clock, reference and pin A0.
+    analogRead(A0);
+
+    // Start a conversion on every START event. The core disables the ADC after each analogRead.
+    ADC->EVCTRL.reg = ADC_EVCTRL_STARTEI;
+    ADC->CTRLA.bit.ENABLE = 1;
+    while (ADC->STATUS.bit.SYNCBUSY);
+
+    timer.begin(ZeroTC45::MICROSECONDS);
+
+    // No callback, so there is no TC5 interrupt. Each overflow starts a conversion.
+    if (timer.routeTc5Event(ZeroTC45::OVERFLOW_EVENT, EVSYS_ID_USER_ADC_START) < 0) {
+        Serial.println("No free event channels.");
+        while (true);
+    }
+
+    // Sample A0 every 1000us, 1000 times a second.
+    timer.startTc5(1000);
+
+    Serial.println("setup done.");
+}
+
+void loop() {
+    delay(500);
+
+    // The latest conversion result.
+    Serial.print("A0: ");
+    Serial.println(ADC->RESULT.reg);
+}
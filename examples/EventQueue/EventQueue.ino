@@ -0,0 +1,60 @@
+/*
+  Demonstrates handling timer events in loop() through a ZeroTC45EventQueue, so no
+  event is lost or merged when loop() is slow.
+
+  The events are only stamped with micros() when the library is built with
+  ZEROTC45_STATS defined, otherwise their time is 0.
+
+  This example code is in the public domain
+*/
+#include <ZeroTC45.h>
+#include <ZeroTC45Queue.h>
+
+// All vars are marked as static as they should not be visible outside the scope of this file.
+
+// Create the timer instance.
+static ZeroTC45 timer;
+
+// Room for 32 events. Both timers push to the same queue.
+static ZeroTC45EventQueue<32> queue;
+
+void setup() {
+    Serial.begin(115200);
+
+    // Wait for a connection from the serial monitor or a terminal emulator.
+    while ( ! Serial);
+
+    timer.begin(ZeroTC45::MILLISECONDS);
+
+    // No callbacks, the interrupt handlers only push to the queue.
+    timer.setTc4Queue(&queue);
+    timer.setTc5Queue(&queue);
+
+    // TC4 every 50 milliseconds and TC5 every 130 milliseconds.
+    timer.startTc4(50);
+    timer.startTc5(130);
+
+    Serial.println("setup done.");
+}
+
+static char msg[64];
+
+void loop() {
+    // Pretend to be busy so several events build up between each drain.
+    delay(400);
+
+    ZeroTC45Event events[8];
+    uint8_t count;
+    while ((count = queue.drain(events, 8)) > 0) {
+        for (uint8_t i = 0; i < count; i++) {
+            snprintf(msg, sizeof(msg), "%8lu: TC%u fired, count %lu",
+                     events[i].micros, events[i].timer, events[i].count);
+            Serial.println(msg);
+        }
+    }
+
+    if (queue.dropped() > 0) {
+        snprintf(msg, sizeof(msg), "%lu events dropped", queue.dropped());
+        Serial.println(msg);
+    }
+}
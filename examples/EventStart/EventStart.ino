@@ -0,0 +1,57 @@
+/*
+  Demonstrates starting a timer of the ZeroTC45 library from an external edge.
+  Connect pin 2 of several boards to the same line and pulse it high, eg from
+  pin 3 of one of them by sending 's' over serial. TC4 on every board starts
+  counting on the rising edge, so the LEDs then toggle in phase.
+
+  This example code is in the public domain
+*/
+#include <ZeroTC45.h>
+
+// All vars are marked as static as they should not be visible outside the scope of this file.
+
+// The pin all the boards share. It must have an external interrupt.
+static const uint8_t SYNC_PIN = 2;
+
+// The pin that drives the shared line on the board that starts the others.
+static const uint8_t PULSE_PIN = 3;
+
+// Create the timer instance.
+static ZeroTC45 timer;
+
+// Any vars used in the callbacks are marked volatile so the compiler doesn't make assumptions
+// about their values. The callbacks run during interrupts so can change the value asynchronously
+// to the main code path.
+static volatile boolean ledOn = false;
+
+void tc4Callback() {
+    ledOn = ! ledOn;
+    digitalWrite(LED_BUILTIN, ledOn ? HIGH : LOW);
+}
+
+void setup() {
+    Serial.begin(115200);
+
+    pinMode(LED_BUILTIN, OUTPUT);
+    pinMode(PULSE_PIN, OUTPUT);
+    digitalWrite(PULSE_PIN, LOW);
+
+    timer.begin(ZeroTC45::MILLISECONDS);
+    timer.setTc4Callback(tc4Callback);
+
+    // Toggle the LED every 500 milliseconds, starting on the first rising edge of SYNC_PIN.
+    uint8_t generator = ZeroTC45::pinEvent(SYNC_PIN);
+    if (generator == 0 || ! timer.startTc4OnEvent(500, generator)) {
+        Serial.println("could not set up the start event.");
+    }
+
+    Serial.println("setup done, waiting for the edge.");
+}
+
+void loop() {
+    if (Serial.read() == 's') {
+        digitalWrite(PULSE_PIN, HIGH);
+        delay(1);
+        digitalWrite(PULSE_PIN, LOW);
+    }
+}
@@ -0,0 +1,95 @@
+/*
+  Demonstrates measuring the pulses of a flow sensor, or any other pulse train,
+  with the capture mode of the ZeroTC45 library. Connect the sensor output to
+  pin 2. TC4 latches the period of each pulse in hardware, so the values have
+  no interrupt latency, and the TC4 callback averages them over blocks of
+  pulses.
+
+  The width of the last pulse is also read with readTc5Capture, by TC5 measuring
+  the same pin through a second event channel.
+
+  This example code is in the public domain
+*/
+#include <ZeroTC45.h>
+
+// All vars are marked as static as they should not be visible outside the scope of this file.
+
+// The pin the sensor is connected to. It must have an external interrupt.
+static const uint8_t SENSOR_PIN = 2;
+
+// The number of periods averaged.
+static const uint16_t BLOCK_LENGTH = 100;
+
+// Create the timer instance.
+static ZeroTC45 timer;
+
+// Any vars used in the callbacks are marked volatile so the compiler doesn't make assumptions
+// about their values. The callbacks run during interrupts so can change the value asynchronously
+// to the main code path.
+static volatile uint32_t averagePeriod = 0;
+static volatile uint32_t blockCount = 0;
+
+// Only used in the callback.
+static uint32_t sum = 0;
+static uint16_t count = 0;
+
+void tc4Callback() {
+    uint16_t period;
+    uint16_t width;
+
+    // A period of 0 means no pulse started for a whole 16-bit count.
+    if ( ! timer.readTc4Capture(period, width) || period == 0) {
+        return;
+    }
+
+    sum += period;
+    if (++count == BLOCK_LENGTH) {
+        averagePeriod = sum / count;
+        blockCount++;
+        sum = 0;
+        count = 0;
+    }
+}
+
+void setup() {
+    Serial.begin(115200);
+
+    // Wait for a connection from the serial monitor or a terminal emulator.
+    while ( ! Serial);
+
+    // Microsecond ticks measure periods of up to 65ms, pulse rates down to about 16Hz.
+    timer.begin(ZeroTC45::MICROSECONDS);
+    timer.setTc4Callback(tc4Callback);
+
+    // The capture modes need the event to follow the level of the pin.
+    uint8_t generator = ZeroTC45::pinEvent(SENSOR_PIN, true);
+
+    if (generator == 0 || ! timer.startTc4Capture(generator)) {
+        Serial.println("could not set up the capture.");
+        while (true);
+    }
+
+    if ( ! timer.startTc5Capture(generator)) {
+        Serial.println("no free event channel for TC5.");
+    }
+
+    Serial.println("setup done.");
+}
+
+static char msg[80];
+
+void loop() {
+    static uint32_t lastCount = 0;
+
+    if (blockCount != lastCount) {
+        lastCount = blockCount;
+
+        uint16_t period;
+        uint16_t width;
+        timer.readTc5Capture(period, width);
+
+        uint32_t hz = (averagePeriod != 0) ? 1000000 / averagePeriod : 0;
+        snprintf(msg, sizeof(msg), "%8lu: block %lu average period %luus, %luHz, last width %uus", millis(), lastCount, averagePeriod, hz, width);
+        Serial.println(msg);
+    }
+}
@@ -0,0 +1,57 @@
+/*
+  Demonstrates driving a servo from a hardware PWM output of the ZeroTC45 library.
+  TC4 makes the 20ms servo frame in match PWM mode on pin A2 (PB09, TC4 WO1) of
+  the Arduino Zero, so there are no interrupts at all. The main loop sweeps the
+  pulse width between 1000us and 2000us by writing the duty cycle.
+
+  This example code is in the public domain
+*/
+#include <ZeroTC45.h>
+
+// All vars are marked as static as they should not be visible outside the scope of this file.
+
+// The servo signal pin. It must be a TC4 WO1 pin for match PWM mode.
+static const uint8_t SERVO_PIN = A2;
+
+// The servo frame and the pulse width range, in microseconds.
+static const uint16_t FRAME = 20000;
+static const uint16_t MIN_WIDTH = 1000;
+static const uint16_t MAX_WIDTH = 2000;
+
+// Create the timer instance.
+static ZeroTC45 timer;
+
+void setup() {
+    Serial.begin(115200);
+
+    timer.begin(ZeroTC45::MICROSECONDS);
+
+    // No callback, so the waveform needs no interrupts.
+    if ( ! timer.startTc4Pwm(SERVO_PIN, MIN_WIDTH, FRAME)) {
+        Serial.println("TC4 can't drive the servo pin.");
+    }
+
+    Serial.println("setup done.");
+}
+
+static char msg[80];
+
+void loop() {
+    static uint16_t width = MIN_WIDTH;
+    static int16_t step = 10;
+
+    width += step;
+    if (width >= MAX_WIDTH || width <= MIN_WIDTH) {
+        step = -step;
+    }
+
+    // A single register write, the frame carries on undisturbed.
+    timer.setTc4Duty(SERVO_PIN, width);
+
+    if (width == MIN_WIDTH || width == MAX_WIDTH) {
+        snprintf(msg, sizeof(msg), "%8lu: pulse width %uus", millis(), width);
+        Serial.println(msg);
+    }
+
+    delay(20);
+}
@@ -0,0 +1,53 @@
+/*
+  Demonstrates starting both timers of the ZeroTC45 library in phase. Every 2
+  seconds TC4 and TC5 are started with the same period, first one after the
+  other with startTc4 and startTc5 and then together with startBoth, and the
+  offset between their counts is shown for each.
+
+  This example code is in the public domain
+*/
+#include <ZeroTC45.h>
+
+// All vars are marked as static as they should not be visible outside the scope of this file.
+
+// The period of both timers in microseconds.
+static const uint16_t PERIOD = 50000;
+
+// Create the timer instance.
+static ZeroTC45 timer;
+
+void setup() {
+    Serial.begin(115200);
+
+    // Wait for a connection from the serial monitor or a terminal emulator.
+    while ( ! Serial);
+
+    timer.begin(ZeroTC45::MICROSECONDS);
+
+    Serial.println("setup done.");
+}
+
+static char msg[80];
+
+// Returns how far TC4 is ahead of TC5 in microseconds, allowing for TC4 having wrapped first.
+static int32_t offset() {
+    int32_t ahead = (int32_t)timer.elapsedTc4() - (int32_t)timer.elapsedTc5();
+    if (ahead < -(int32_t)PERIOD / 2) {
+        ahead += PERIOD;
+    }
+    return ahead;
+}
+
+void loop() {
+    timer.startTc4(PERIOD);
+    timer.startTc5(PERIOD);
+    int32_t separate = offset();
+
+    timer.startBoth(PERIOD, PERIOD);
+    int32_t together = offset();
+
+    snprintf(msg, sizeof(msg), "%8lu: TC4 ahead of TC5 by %ldus started separately, %ldus with startBoth", millis(), separate, together);
+    Serial.println(msg);
+
+    delay(2000);
+}
@@ -0,0 +1,50 @@
+/*
+  Demonstrates the microsecond and custom tick rates of the ZeroTC45 library.
+
+  This example code is in the public domain
+*/
+#include <ZeroTC45.h>
+
+// All vars are marked as static as they should not be visible outside the scope of this file.
+
+// Create the timer instance.
+static ZeroTC45 timer;
+
+// 10us ticks from the 48MHz DFLL. The divisors are worked out at compile time
+// and it fails to compile if the rate cannot be made exactly.
+typedef ZeroTC45TickRate<100000> TenMicroseconds;
+
+// Any vars used in the callbacks are marked volatile so the compiler doesn't make assumptions
+// about their values. The callbacks run during interrupts so can change the value asynchronously
+// to the main code path.
+static volatile uint32_t tc4Count = 0;
+
+void tc4Callback() {
+    tc4Count++;
+}
+
+void setup() {
+    Serial.begin(115200);
+
+    // Wait for a connection from the serial monitor or a terminal emulator.
+    while ( ! Serial);
+
+    timer.begin(TenMicroseconds::config());
+
+    Serial.print("Tick rate: ");
+    Serial.print(ZeroTC45::tickHz(timer.getClockConfig()));
+    Serial.println("Hz");
+
+    // Call the callback every 500us (50 ticks of 10us), 2000 times a second.
+    timer.setTc4Callback(tc4Callback);
+    timer.startTc4(50);
+
+    Serial.println("setup done.");
+}
+
+void loop() {
+    delay(1000);
+    Serial.print("Callbacks in the last second: ");
+    Serial.println(tc4Count);
+    tc4Count = 0;
+}
@@ -0,0 +1,60 @@
+/*
+  Demonstrates running TC4 in milliseconds and TC5 in seconds with the ZeroTC45 library.
+
+  This example code is in the public domain
+*/
+#include <ZeroTC45.h>
+
+// All vars are marked as static as they should not be visible outside the scope of this file.
+
+// Create the timer instance.
+static ZeroTC45 timer;
+
+// Any vars used in the callbacks are marked volatile so the compiler doesn't make assumptions
+// about their values. The callbacks run during interrupts so can change the value asynchronously
+// to the main code path.
+static volatile uint32_t tc4Count = 0;
+static volatile boolean heartbeat = false;
+
+void tc4Callback() {
+    tc4Count++;
+}
+
+void tc5Callback() {
+    // Do minimal processing in the callback and just set a flag
+    // to indicate the main code path should take some action.
+    heartbeat = true;
+}
+
+void setup() {
+    Serial.begin(115200);
+
+    // Wait for a connection from the serial monitor or a terminal emulator.
+    while ( ! Serial);
+
+    // TC4 ticks in milliseconds and TC5 in seconds. Both run from the 32kHz crystal.
+    if ( ! timer.begin(ZeroTC45::MILLISECONDS, ZeroTC45::SECONDS)) {
+        Serial.println("The resolutions can't be used together.");
+        while (true);
+    }
+
+    // Call tc4Callback every 10 milliseconds.
+    timer.setTc4Callback(tc4Callback);
+    timer.startTc4(10);
+
+    // Call tc5Callback every 5 seconds.
+    timer.setTc5Callback(tc5Callback);
+    timer.startTc5(5);
+
+    Serial.println("setup done.");
+}
+
+static char msg[64];
+
+void loop() {
+    if (heartbeat) {
+        heartbeat = false;
+        snprintf(msg, sizeof(msg), "%8lu: heartbeat, %lu TC4 callbacks so far", millis(), tc4Count);
+        Serial.println(msg);
+    }
+}
@@ -0,0 +1,74 @@
+/*
+  Demonstrates running TC3 and TCC0 as well as TC4 and TC5 with the ZeroTC45
+  library, for four periodic timers in hardware at once.
+
+  This example code is in the public domain
+*/
+#include <ZeroTC45.h>
+#include <ZeroTC45Timer.h>
+
+// All vars are marked as static as they should not be visible outside the scope of this file.
+
+// Create the timer instance.
+static ZeroTC45 timer;
+
+// The other timers are static classes, one per peripheral.
+typedef ZeroTC45Timer<ZeroTC45Tc3> Tc3Timer;
+typedef ZeroTC45Timer<ZeroTC45Tcc0> Tcc0Timer;
+
+// Any vars used in the callbacks are marked volatile so the compiler doesn't make assumptions
+// about their values. The callbacks run during interrupts so can change the value asynchronously
+// to the main code path.
+static volatile uint32_t tc3Fires = 0;
+static volatile uint32_t tc4Fires = 0;
+static volatile uint32_t tc5Fires = 0;
+static volatile uint32_t tcc0Fires = 0;
+
+void tc3Callback() {
+    tc3Fires++;
+}
+
+void tc4Callback() {
+    tc4Fires++;
+}
+
+void tc5Callback() {
+    tc5Fires++;
+}
+
+void tcc0Callback() {
+    tcc0Fires++;
+}
+
+void setup() {
+    Serial.begin(115200);
+
+    // Wait for a connection from the serial monitor or a terminal emulator.
+    while ( ! Serial);
+
+    // All four timers tick at 1024Hz from the GCLK set up here.
+    timer.begin(ZeroTC45::MILLISECONDS);
+    Tc3Timer::begin(timer);
+    Tcc0Timer::begin(timer);
+
+    timer.setTc4Callback(tc4Callback);
+    timer.setTc5Callback(tc5Callback);
+    Tc3Timer::setCallback(tc3Callback);
+    Tcc0Timer::setCallback(tcc0Callback);
+
+    timer.startTc4(1024);       // 1 second.
+    timer.startTc5(512);        // 0.5 seconds.
+    Tc3Timer::start(256);       // 0.25 seconds.
+    Tcc0Timer::start(102400);   // 100 seconds, TCC0 has a 24-bit counter.
+
+    Serial.println("setup done.");
+}
+
+static char msg[80];
+
+void loop() {
+    delay(1000);
+
+    snprintf(msg, sizeof(msg), "TC3 %lu, TC4 %lu, TC5 %lu, TCC0 %lu", tc3Fires, tc4Fires, tc5Fires, tcc0Fires);
+    Serial.println(msg);
+}
@@ -67,8 +67,10 @@ void loop() {
     if (restartTimer) {
         period += 2;
         // Re-initialise to get a proper delta value.
+        // TC4 is already configured as a one-shot so restarting it only needs
+        // a few register writes, and the async version doesn't wait for them.
         tc4IsrMs = millis();
-        timer.startTc4(period, true);
+        timer.startTc4Async(period, true);
         Serial.println("One shot operation started.");
     }
 }
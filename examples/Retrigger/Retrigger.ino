@@ -0,0 +1,56 @@
+/*
+  Demonstrates using retriggerTc4 of the ZeroTC45 library as an inactivity timeout.
+
+  This example code is in the public domain
+*/
+#include <ZeroTC45.h>
+
+// All vars are marked as static as they should not be visible outside the scope of this file.
+
+// Create the timer instance.
+static ZeroTC45 timer;
+
+// Any vars used in the callbacks are marked volatile so the compiler doesn't make assumptions
+// about their values. The callbacks run during interrupts so can change the value asynchronously
+// to the main code path.
+static volatile boolean timedOut = false;
+
+void tc4Callback() {
+    // Do minimal processing in the callback and just set a flag
+    // to indicate the main code path should take some action.
+    timedOut = true;
+}
+
+void setup() {
+    Serial.begin(115200);
+
+    // Wait for a connection from the serial monitor or a terminal emulator.
+    while ( ! Serial);
+
+    timer.begin(ZeroTC45::MILLISECONDS);
+
+    // Start a 3 second one-shot. It is restarted every time a character is received
+    // so it only fires after 3 seconds with no input.
+    timer.setTc4Callback(tc4Callback);
+    timer.startTc4(3000, true);
+
+    Serial.println("setup done.");
+}
+
+void loop() {
+    boolean activity = false;
+    while (Serial.available()) {
+        Serial.read();
+        activity = true;
+    }
+
+    if (activity) {
+        // A single register write, no reconfiguration.
+        timer.retriggerTc4();
+    }
+
+    if (timedOut) {
+        timedOut = false;
+        Serial.println("No input for 3 seconds.");
+    }
+}
@@ -0,0 +1,68 @@
+/*
+  Demonstrates sampling an analog pin into a double buffer with the ZeroTC45Sampler.
+  TC5 starts each conversion and the DMAC stores the results, so the only interrupt
+  is one per block of samples.
+
+  This example code is in the public domain
+*/
+#include <ZeroTC45Sampler.h>
+
+// All vars are marked as static as they should not be visible outside the scope of this file.
+
+// The number of samples in each half of the buffer.
+static const uint16_t BLOCK_LENGTH = 250;
+
+// Create the timer and sampler instances.
+static ZeroTC45 timer;
+static ZeroTC45Sampler sampler(timer);
+
+// The DMAC fills one half of the buffer while the other is processed.
+static volatile uint16_t samples[2 * BLOCK_LENGTH];
+
+// Any vars used in the callbacks are marked volatile so the compiler doesn't make assumptions
+// about their values. The callbacks run during interrupts so can change the value asynchronously
+// to the main code path.
+static volatile uint32_t blockAverage = 0;
+static volatile uint32_t blockCount = 0;
+
+void blockCallback(const volatile uint16_t* block, uint16_t count) {
+    // The block isn't written again until the other half is full, a quarter of a second from now.
+    uint32_t sum = 0;
+    for (uint16_t i = 0; i < count; i++) {
+        sum += block[i];
+    }
+
+    blockAverage = sum / count;
+    blockCount++;
+}
+
+void setup() {
+    Serial.begin(115200);
+
+    // Wait for a connection from the serial monitor or a terminal emulator.
+    while ( ! Serial);
+
+    timer.begin(ZeroTC45::MICROSECONDS);
+
+    if ( ! sampler.begin(A0, samples, 2 * BLOCK_LENGTH, blockCallback)) {
+        Serial.println("No free DMA or event channel.");
+        while (true);
+    }
+
+    // Sample A0 every 1000us, so each block of 250 samples takes a quarter of a second.
+    sampler.start(1000);
+
+    Serial.println("setup done.");
+}
+
+static char msg[64];
+
+void loop() {
+    static uint32_t lastCount = 0;
+
+    if (blockCount != lastCount) {
+        lastCount = blockCount;
+        snprintf(msg, sizeof(msg), "%8lu: block %lu average %lu", millis(), lastCount, blockAverage);
+        Serial.println(msg);
+    }
+}
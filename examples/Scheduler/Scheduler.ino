@@ -0,0 +1,74 @@
+/*
+  Demonstrates the use of the ZeroTC45Scheduler to run many timers on TC4.
+
+  This example code is in the public domain
+*/
+#include <ZeroTC45.h>
+#include <ZeroTC45Scheduler.h>
+
+// All vars are marked as static as they should not be visible outside the scope of this file.
+
+// Create the timer instance, and the scheduler that runs virtual timers on its TC4.
+static ZeroTC45 timer;
+static ZeroTC45Scheduler scheduler(timer);
+
+// Any vars used in the callbacks are marked volatile so the compiler doesn't make assumptions
+// about their values. The callbacks run during interrupts so can change the value asynchronously
+// to the main code path.
+static volatile uint32_t fastCount = 0;
+static volatile uint32_t slowCount = 0;
+static volatile boolean reportDue = false;
+static volatile boolean oneShotTriggered = false;
+
+static ZeroTC45Scheduler::TimerId fastTimer;
+
+void fastCallback() {
+    fastCount++;
+}
+
+void slowCallback() {
+    slowCount++;
+}
+
+void reportCallback() {
+    reportDue = true;
+}
+
+void oneShotCallback() {
+    oneShotTriggered = true;
+}
+
+void setup() {
+    Serial.begin(115200);
+
+    // Wait for a connection from the serial monitor or a terminal emulator.
+    while ( ! Serial);
+
+    // The scheduler ticks at the resolution given to begin.
+    timer.begin(ZeroTC45::MILLISECONDS);
+    scheduler.begin();
+
+    // Periodic timers at 10ms, 250ms and 1s, and a one-shot timer in 5s.
+    fastTimer = scheduler.startTimer(10, fastCallback);
+    scheduler.startTimer(250, slowCallback);
+    scheduler.startTimer(1000, reportCallback);
+    scheduler.startTimer(5000, oneShotCallback, true);
+
+    Serial.println("setup done.");
+}
+
+static char msg[64];
+
+void loop() {
+    if (reportDue) {
+        reportDue = false;
+        snprintf(msg, sizeof(msg), "%8lu: fast %lu, slow %lu", scheduler.now(), fastCount, slowCount);
+        Serial.println(msg);
+    }
+
+    if (oneShotTriggered) {
+        oneShotTriggered = false;
+        scheduler.stopTimer(fastTimer);
+        Serial.println("One shot timer triggered, fast timer stopped.");
+    }
+}
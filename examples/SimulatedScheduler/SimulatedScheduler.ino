@@ -0,0 +1,69 @@
+/*
+  Demonstrates running the scheduler of the ZeroTC45 library against the
+  simulated timer ZeroTC45Sim. A million virtual timer expiries are run in
+  virtual time, as fast as the scheduling code allows, and the result is
+  checked against the expected count. No TC is used.
+
+  The same code builds on a host computer with the library src folder on the
+  include path and ZeroTC45Sim.cpp compiled in, for regression tests and
+  benchmarks of scheduling code off the board.
+
+  This example code is in the public domain
+*/
+#include <ZeroTC45Sim.h>
+#include <ZeroTC45Scheduler.h>
+
+// All vars are marked as static as they should not be visible outside the scope of this file.
+
+// The number of virtual timer expiries to run.
+static const uint32_t EVENTS = 1000000;
+
+// Create the simulated timer, and a scheduler that runs virtual timers on it.
+static ZeroTC45Sim sim;
+static ZeroTC45BasicScheduler<ZeroTC45Sim> scheduler(sim);
+
+// The callbacks are called from ZeroTC45Sim::advance, not from an interrupt.
+static uint32_t fastCount = 0;
+static uint32_t slowCount = 0;
+
+void fastCallback() {
+    fastCount++;
+}
+
+void slowCallback() {
+    slowCount++;
+}
+
+void setup() {
+    Serial.begin(115200);
+
+    // Wait for a connection from the serial monitor or a terminal emulator.
+    while ( ! Serial);
+
+    scheduler.begin();
+
+    // 40 timers every 7 ticks and 8 every 1000 ticks, so several expire at the same tick.
+    for (uint8_t i = 0; i < 40; i++) {
+        scheduler.startTimer(7, fastCallback);
+    }
+    for (uint8_t i = 0; i < 8; i++) {
+        scheduler.startTimer(1000, slowCallback);
+    }
+
+    uint32_t start = millis();
+    while (fastCount + slowCount < EVENTS && sim.advanceToDeadline());
+    uint32_t elapsed = millis() - start;
+
+    // Each timer is due at a multiple of its period, so the counts follow from the virtual time.
+    uint32_t ticks = (uint32_t)sim.now();
+    boolean ok = (fastCount == 40 * (ticks / 7)) && (slowCount == 8 * (ticks / 1000));
+
+    static char msg[80];
+    snprintf(msg, sizeof(msg), "%lu ticks, %lu fast, %lu slow, %s", ticks, fastCount, slowCount, ok ? "ok" : "WRONG");
+    Serial.println(msg);
+    snprintf(msg, sizeof(msg), "%lu expiries in %lums", fastCount + slowCount, elapsed);
+    Serial.println(msg);
+}
+
+void loop() {
+}
@@ -0,0 +1,55 @@
+/*
+  Demonstrates sleepUntilNextTimer of the ZeroTC45 library. TC4 runs from the
+  32kHz oscillator, which keeps running in standby, so loop() spends almost all
+  of its time in standby and only wakes to flash the LED every 2 seconds.
+
+  USB is disconnected in standby, so the time slept is reported on Serial1.
+
+  This example code is in the public domain
+*/
+#include <ZeroTC45.h>
+
+// All vars are marked as static as they should not be visible outside the scope of this file.
+
+// Create the timer instance.
+static ZeroTC45 timer;
+
+// Any vars used in the callbacks are marked volatile so the compiler doesn't make assumptions
+// about their values. The callbacks run during interrupts so can change the value asynchronously
+// to the main code path.
+static volatile uint32_t fires = 0;
+
+void tc4Callback() {
+    fires++;
+}
+
+void setup() {
+    Serial1.begin(115200);
+    pinMode(LED_BUILTIN, OUTPUT);
+
+    timer.begin(ZeroTC45::MILLISECONDS);
+
+    // Wake every 2000 milliseconds.
+    timer.setTc4Callback(tc4Callback);
+    timer.startTc4(2000);
+
+    Serial1.println("setup done.");
+}
+
+static char msg[80];
+
+// The time slept since setup, which millis() doesn't count in standby.
+static uint32_t sleptMs = 0;
+
+void loop() {
+    uint32_t ms = timer.sleepUntilNextTimer();
+    sleptMs += ms;
+
+    digitalWrite(LED_BUILTIN, HIGH);
+    delay(10);
+    digitalWrite(LED_BUILTIN, LOW);
+
+    snprintf(msg, sizeof(msg), "fire %lu, slept %lums, %lums in total", fires, ms, sleptMs);
+    Serial1.println(msg);
+    Serial1.flush();
+}
@@ -0,0 +1,67 @@
+/*
+  Demonstrates the timing statistics of the ZeroTC45 library. The TC4 callback
+  sometimes takes longer than its period, and interrupts are sometimes disabled
+  for longer than a period, and both show up in the statistics.
+
+  The library only times the interrupts when it is built with ZEROTC45_STATS
+  defined, which has to be given for the whole build, eg with arduino-cli
+
+    arduino-cli compile --build-property "compiler.cpp.extra_flags=-DZEROTC45_STATS" ...
+
+  Without it only the fires are counted.
+
+  This example code is in the public domain
+*/
+#include <ZeroTC45.h>
+
+// All vars are marked as static as they should not be visible outside the scope of this file.
+
+// Create the timer instance.
+static ZeroTC45 timer;
+
+// Any vars used in the callbacks are marked volatile so the compiler doesn't make assumptions
+// about their values. The callbacks run during interrupts so can change the value asynchronously
+// to the main code path.
+static volatile uint32_t calls = 0;
+
+void tc4Callback() {
+    // Every 100th call takes 3ms, longer than the 2ms period.
+    if (++calls % 100 == 0) {
+        delayMicroseconds(3000);
+    }
+}
+
+void setup() {
+    Serial.begin(115200);
+
+    // Wait for a connection from the serial monitor or a terminal emulator.
+    while ( ! Serial);
+
+    timer.begin(ZeroTC45::MICROSECONDS);
+
+    // Call tc4Callback every 2000us.
+    timer.setTc4Callback(tc4Callback);
+    timer.startTc4(2000);
+
+#if !defined(ZEROTC45_STATS)
+    Serial.println("ZEROTC45_STATS is not defined, so the callbacks are not timed.");
+#endif
+
+    Serial.println("setup done.");
+}
+
+static char msg[96];
+
+void loop() {
+    delay(1000);
+
+    // Disable interrupts for 5ms, so at least one overflow is lost.
+    noInterrupts();
+    delayMicroseconds(5000);
+    interrupts();
+
+    ZeroTC45::Stats stats = timer.getTc4Stats();
+    snprintf(msg, sizeof(msg), "fires %lu, overruns %lu, missed %lu, longest callback %luus",
+             stats.fires, stats.overruns, stats.missed, stats.maxCallbackCycles / (SystemCoreClock / 1000000));
+    Serial.println(msg);
+}
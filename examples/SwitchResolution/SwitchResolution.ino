@@ -0,0 +1,61 @@
+/*
+  Demonstrates switching the resolution of TC4 at run time with the ZeroTC45
+  library. TC4 alternates between an acquisition phase, firing every 100
+  milliseconds, and an idle phase, firing every 5 seconds. Only the TC4
+  prescaler changes, so the switch takes microseconds.
+
+  This example code is in the public domain
+*/
+#include <ZeroTC45.h>
+
+// All vars are marked as static as they should not be visible outside the scope of this file.
+
+// Create the timer instance.
+static ZeroTC45 timer;
+
+// Any vars used in the callbacks are marked volatile so the compiler doesn't make assumptions
+// about their values. The callbacks run during interrupts so can change the value asynchronously
+// to the main code path.
+static volatile uint32_t fires = 0;
+
+void tc4Callback() {
+    fires++;
+}
+
+static char msg[80];
+
+void setup() {
+    Serial.begin(115200);
+
+    // Wait for a connection from the serial monitor or a terminal emulator.
+    while ( ! Serial);
+
+    timer.begin(ZeroTC45::MILLISECONDS);
+    timer.setTc4Callback(tc4Callback);
+
+    Serial.println("setup done.");
+}
+
+void loop() {
+    // Acquisition: every 100 milliseconds for 10 seconds.
+    uint32_t start = micros();
+    timer.setTc4Resolution(ZeroTC45::MILLISECONDS);
+    timer.startTc4(100);
+    uint32_t switchMicros = micros() - start;
+
+    fires = 0;
+    delay(10000);
+    snprintf(msg, sizeof(msg), "acquisition: %lu fires, switched in %luus", fires, switchMicros);
+    Serial.println(msg);
+
+    // Idle: every 5 seconds for 20 seconds.
+    start = micros();
+    timer.setTc4Resolution(ZeroTC45::SECONDS);
+    timer.startTc4(5);
+    switchMicros = micros() - start;
+
+    fires = 0;
+    delay(20000);
+    snprintf(msg, sizeof(msg), "idle: %lu fires, switched in %luus", fires, switchMicros);
+    Serial.println(msg);
+}
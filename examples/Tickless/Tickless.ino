@@ -0,0 +1,63 @@
+/*
+  Demonstrates the tickless mode of the ZeroTC45 library for the Arduino Zero and similar.
+
+  This example code is in the public domain
+*/
+#include <ZeroTC45.h>
+
+// All vars are marked as static as they should not be visible outside the scope of this file.
+
+// Create the timer instance.
+static ZeroTC45 timer;
+
+// Any vars used in the callbacks are marked volatile so the compiler doesn't make assumptions
+// about their values. The callbacks run during interrupts so can change the value asynchronously
+// to the main code path.
+static volatile boolean tc4IsrTriggered = false;
+static volatile uint32_t tc4IsrTicks = 0;
+
+// The gap between deadlines, in milliseconds. Each deadline is further away than the last.
+static uint32_t gap = 100;
+static uint32_t deadline = 0;
+
+void tc4Callback() {
+    // Do minimal processing in the callback and just set a flag
+    // to indicate the main code path should take some action.
+    tc4IsrTicks = timer.getTc4Ticks();
+    tc4IsrTriggered = true;
+
+    // Set the next deadline. There are no interrupts between deadlines
+    // other than two every 65536 ticks to keep track of the count.
+    gap += 100;
+    deadline += gap;
+    timer.setTc4Deadline(deadline);
+}
+
+void setup() {
+    Serial.begin(115200);
+
+    // Wait for a connection from the serial monitor or a terminal emulator.
+    while ( ! Serial);
+
+    // Put the timers in milliseconds mode.
+    timer.begin(ZeroTC45::MILLISECONDS);
+
+    // Start TC4 counting, with the first deadline 100ms from now.
+    timer.setTc4Callback(tc4Callback);
+    timer.startTc4Tickless();
+
+    deadline = timer.getTc4Ticks() + gap;
+    timer.setTc4Deadline(deadline);
+
+    Serial.println("setup done.");
+}
+
+static char msg[64];
+
+void loop() {
+    if (tc4IsrTriggered) {
+        tc4IsrTriggered = false;
+        snprintf(msg, sizeof(msg), "TC4 deadline reached at tick %lu", tc4IsrTicks);
+        Serial.println(msg);
+    }
+}
@@ -0,0 +1,68 @@
+/*
+  Demonstrates reading how far a timer of the ZeroTC45 library has counted
+  without stopping it. TC4 runs a 2 second reply timeout as a one-shot, while
+  the main loop waits for a reply on serial and shows the time left.
+
+  This example code is in the public domain
+*/
+#include <ZeroTC45.h>
+
+// All vars are marked as static as they should not be visible outside the scope of this file.
+
+// The time allowed for a reply, in milliseconds.
+static const uint16_t TIMEOUT = 2000;
+
+// Create the timer instance.
+static ZeroTC45 timer;
+
+// Any vars used in the callbacks are marked volatile so the compiler doesn't make assumptions
+// about their values. The callbacks run during interrupts so can change the value asynchronously
+// to the main code path.
+static volatile boolean timedOut = false;
+
+void tc4Callback() {
+    timedOut = true;
+}
+
+void setup() {
+    Serial.begin(115200);
+
+    // Wait for a connection from the serial monitor or a terminal emulator.
+    while ( ! Serial);
+
+    timer.begin(ZeroTC45::MILLISECONDS);
+    timer.setTc4Callback(tc4Callback);
+
+    Serial.println("setup done, send any character within 2 seconds.");
+    timer.startTc4(TIMEOUT, true);
+}
+
+static char msg[80];
+
+void loop() {
+    static uint32_t lastReport = 0;
+
+    if (Serial.available()) {
+        Serial.read();
+
+        // The count is read continuously, so this doesn't wait for the TC clock.
+        snprintf(msg, sizeof(msg), "%8lu: reply after %lums, %lums to spare", millis(), timer.elapsedTc4(), timer.remainingTc4());
+        Serial.println(msg);
+
+        timedOut = false;
+        timer.startTc4(TIMEOUT, true);
+    }
+
+    if (timedOut) {
+        timedOut = false;
+        snprintf(msg, sizeof(msg), "%8lu: timed out, starting again", millis());
+        Serial.println(msg);
+        timer.startTc4(TIMEOUT, true);
+    }
+
+    if (millis() - lastReport >= 500) {
+        lastReport = millis();
+        snprintf(msg, sizeof(msg), "%8lu: %lums left", millis(), timer.remainingTc4());
+        Serial.println(msg);
+    }
+}
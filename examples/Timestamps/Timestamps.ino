@@ -0,0 +1,55 @@
+/*
+  Demonstrates the ZeroTC45Timestamp 64-bit clock. TC5 runs freely from the
+  32kHz crystal and keeps counting in standby, where SysTick and so millis()
+  stop. TC4 wakes the board from standby every 5 seconds, and each wake is
+  logged with its timestamp next to millis(), which falls behind.
+
+  USB is disconnected in standby, so the log is written to Serial1.
+
+  This example code is in the public domain
+*/
+#include <ZeroTC45Timestamp.h>
+
+// All vars are marked as static as they should not be visible outside the scope of this file.
+
+// Create the timer and timestamp instances.
+static ZeroTC45 timer;
+static ZeroTC45Timestamp timestamp(timer);
+
+// Any vars used in the callbacks are marked volatile so the compiler doesn't make assumptions
+// about their values. The callbacks run during interrupts so can change the value asynchronously
+// to the main code path.
+static volatile uint64_t lastWake = 0;
+
+void tc4Callback() {
+    // Taking a timestamp doesn't disable interrupts, so it is cheap to do in a callback.
+    lastWake = timestamp.now();
+}
+
+void setup() {
+    Serial1.begin(115200);
+
+    // Both timers run from the crystal, which keeps running in standby.
+    timer.begin(ZeroTC45::CRYSTAL_MILLISECONDS);
+
+    if ( ! timestamp.begin()) {
+        Serial1.println("the TC5 clock stops in standby.");
+    }
+
+    timer.setTc4Callback(tc4Callback);
+    timer.startTc4(5000);
+
+    Serial1.println("setup done.");
+}
+
+static char msg[80];
+
+void loop() {
+    timer.sleepUntilNextTimer();
+
+    // The timestamp was taken in the callback, at the wake-up itself.
+    uint32_t wakeMs = timestamp.toMicros(lastWake) / 1000;
+    snprintf(msg, sizeof(msg), "woke at %lums by the timestamp, millis() says %lums", wakeMs, millis());
+    Serial1.println(msg);
+    Serial1.flush();
+}
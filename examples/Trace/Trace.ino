@@ -0,0 +1,78 @@
+/*
+  Demonstrates tracing the ZeroTC45 library. TC4 fires every millisecond and
+  TC5 every 3 milliseconds, and a pin interrupt on pin 2 is traced alongside
+  them with ZeroTC45Trace::mark. Every second the latest records are printed,
+  showing how long each handler ran and what it held up.
+
+  The library only adds its trace records when it is built with ZEROTC45_TRACE
+  defined, which has to be given for the whole build, eg with arduino-cli
+
+    arduino-cli compile --build-property "compiler.cpp.extra_flags=-DZEROTC45_TRACE" ...
+
+  Without it only the pin interrupt is traced.
+
+  This example code is in the public domain
+*/
+#include <ZeroTC45.h>
+#include <ZeroTC45Trace.h>
+
+// All vars are marked as static as they should not be visible outside the scope of this file.
+
+// Create the timer instance.
+static ZeroTC45 timer;
+
+// The trace source number for the pin interrupt, anything but 4 and 5.
+static const uint8_t PIN_SOURCE = 2;
+
+// Any vars used in the callbacks are marked volatile so the compiler doesn't make assumptions
+// about their values. The callbacks run during interrupts so can change the value asynchronously
+// to the main code path.
+static volatile uint32_t tc4Count = 0;
+static volatile uint32_t tc5Count = 0;
+
+void tc4Callback() {
+    tc4Count++;
+}
+
+void tc5Callback() {
+    // Long enough to see TC4 wait for it in the trace.
+    delayMicroseconds(200);
+    tc5Count++;
+}
+
+void pinChanged() {
+    ZeroTC45Trace::mark(PIN_SOURCE, ZeroTC45Trace::ENTER);
+    ZeroTC45Trace::mark(PIN_SOURCE, ZeroTC45Trace::EXIT);
+}
+
+void setup() {
+    Serial.begin(115200);
+    while (!Serial);
+
+#if !defined(ZEROTC45_TRACE)
+    Serial.println("ZEROTC45_TRACE is not defined, so the timers are not traced.");
+#endif
+
+    pinMode(2, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(2), pinChanged, CHANGE);
+
+    timer.begin(ZeroTC45::MILLISECONDS);
+    timer.setTc4Callback(tc4Callback);
+    timer.setTc5Callback(tc5Callback);
+    timer.startTc4(1);
+    timer.startTc5(3);
+
+    Serial.println("setup done.");
+}
+
+static char msg[80];
+
+void loop() {
+    delay(1000);
+
+    // Only the last ZeroTC45Trace::SIZE records are kept, the rest are reported as lost.
+    snprintf(msg, sizeof(msg), "TC4 %lu, TC5 %lu, %lu clocks a millisecond",
+             (unsigned long)tc4Count, (unsigned long)tc5Count, (unsigned long)(SystemCoreClock / 1000));
+    Serial.println(msg);
+    ZeroTC45Trace::dump(Serial);
+}
@@ -0,0 +1,254 @@
+/*
+  ZeroTC45 library for Arduino Zero and similar.
+
+  Copyright (c) 2020 David Taylor. All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 3.0 of the License, or (at your option) any later version.
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+/*
+  Host regression tests of ZeroTC45BasicScheduler, run against the simulated
+  timer ZeroTC45Sim. Build and run them with make in this folder.
+*/
+
+#include <stdio.h>
+
+#include "ZeroTC45Sim.h"
+#include "ZeroTC45Scheduler.h"
+
+typedef ZeroTC45BasicScheduler<ZeroTC45Sim> Scheduler;
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if ( ! (condition)) { \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+        } \
+    } while (0)
+
+// The simulation and scheduler of the test being run, for the callbacks.
+static ZeroTC45Sim* sim;
+static Scheduler* scheduler;
+
+// The virtual times each callback was called at.
+static const uint8_t MAX_CALLS = 32;
+static uint64_t callsA[MAX_CALLS];
+static uint64_t callsB[MAX_CALLS];
+static uint32_t countA;
+static uint32_t countB;
+
+// Set by a test for callbackA to stop, or INVALID_TIMER.
+static Scheduler::TimerId stopFromA;
+static boolean stopResult;
+
+static void reset(ZeroTC45Sim& s, Scheduler& sch) {
+    sim = &s;
+    scheduler = &sch;
+    countA = 0;
+    countB = 0;
+    stopFromA = Scheduler::INVALID_TIMER;
+    stopResult = false;
+}
+
+static void callbackA() {
+    if (countA < MAX_CALLS) {
+        callsA[countA] = sim->now();
+    }
+    countA++;
+
+    if (stopFromA != Scheduler::INVALID_TIMER) {
+        stopResult = scheduler->stopTimer(stopFromA);
+        stopFromA = Scheduler::INVALID_TIMER;
+    }
+}
+
+static void callbackB() {
+    if (countB < MAX_CALLS) {
+        callsB[countB] = sim->now();
+    }
+    countB++;
+}
+
+// Timers expire in deadline order, whatever order they were started in.
+static void testOrdering() {
+    ZeroTC45Sim s;
+    Scheduler sch(s);
+    reset(s, sch);
+    sch.begin();
+
+    CHECK(sch.startTimer(30, callbackB, true) != Scheduler::INVALID_TIMER);
+    CHECK(sch.startTimer(10, callbackA, true) != Scheduler::INVALID_TIMER);
+    CHECK(sch.startTimer(20, callbackA, true) != Scheduler::INVALID_TIMER);
+
+    s.advance(25);
+    CHECK(countA == 2);
+    CHECK(callsA[0] == 10);
+    CHECK(callsA[1] == 20);
+    CHECK(countB == 0);
+
+    s.advance(10);
+    CHECK(countB == 1);
+    CHECK(callsB[0] == 30);
+
+    // All one-shots are done, so there is no deadline left.
+    CHECK( ! s.advanceToDeadline());
+}
+
+// A periodic timer is rescheduled from its deadline, so it stays on multiples of its period.
+static void testPeriodicDrift() {
+    ZeroTC45Sim s;
+    Scheduler sch(s);
+    reset(s, sch);
+    sch.begin();
+
+    CHECK(sch.startTimer(7, callbackA) != Scheduler::INVALID_TIMER);
+    CHECK(sch.startTimer(1000, callbackB) != Scheduler::INVALID_TIMER);
+
+    // Move time on in steps that don't line up with either period.
+    for (uint16_t i = 0; i < 3000; i++) {
+        s.advance(3);
+    }
+
+    CHECK(countA == 9000 / 7);
+    CHECK(countB == 9);
+    for (uint8_t i = 0; i < MAX_CALLS; i++) {
+        CHECK(callsA[i] == 7u * (i + 1));
+    }
+    for (uint8_t i = 0; i < 9; i++) {
+        CHECK(callsB[i] == 1000u * (i + 1));
+    }
+}
+
+// A callback can stop itself and other timers, including one due at the same tick.
+static void testStopFromCallback() {
+    ZeroTC45Sim s;
+    Scheduler sch(s);
+    reset(s, sch);
+    sch.begin();
+
+    Scheduler::TimerId a = sch.startTimer(10, callbackA);
+    Scheduler::TimerId b = sch.startTimer(10, callbackB);
+    CHECK(a != Scheduler::INVALID_TIMER && b != Scheduler::INVALID_TIMER);
+
+    stopFromA = b;
+    s.advance(10);
+    CHECK(stopResult);
+    CHECK( ! sch.isRunning(b));
+    CHECK(countA == 1);
+
+    stopFromA = a;
+    s.advance(10);
+    CHECK(stopResult);
+    CHECK( ! sch.isRunning(a));
+    CHECK(countA == 2);
+
+    // b was due at tick 10 too but was stopped before its callback, and neither runs again.
+    s.advance(100);
+    CHECK(countA == 2);
+    CHECK(countB == 0);
+    CHECK( ! s.advanceToDeadline());
+}
+
+// After end, and before begin, no timer is running and stopping one is refused.
+static void testStopAfterEnd() {
+    ZeroTC45Sim s;
+    Scheduler sch(s);
+    reset(s, sch);
+
+    CHECK( ! sch.isRunning(0));
+    CHECK( ! sch.stopTimer(0));
+
+    sch.begin();
+    Scheduler::TimerId a = sch.startTimer(10, callbackA);
+    Scheduler::TimerId b = sch.startTimer(20, callbackB, true);
+    CHECK(sch.isRunning(a) && sch.isRunning(b));
+
+    sch.end();
+    CHECK( ! sch.isRunning(a));
+    CHECK( ! sch.isRunning(b));
+    CHECK( ! sch.stopTimer(a));
+    CHECK( ! sch.stopTimer(b));
+
+    // The scheduler can be started again afterwards.
+    sch.begin();
+    CHECK(sch.startTimer(5, callbackA, true) != Scheduler::INVALID_TIMER);
+    s.advance(5);
+    CHECK(countA == 1);
+}
+
+// Starts two one-shots from a callback.
+static void callbackStart() {
+    countB++;
+    scheduler->startTimer(1, callbackA, true);
+    scheduler->startTimer(2, callbackA, true);
+}
+
+static void callbackEnd() {
+    countB++;
+    scheduler->end();
+}
+
+// Timers started from a callback are armed once, after the callbacks, not once each.
+static void testArmOnceFromCallback() {
+    ZeroTC45Sim s;
+    Scheduler sch(s);
+    reset(s, sch);
+    sch.begin();
+
+    sch.startTimer(10, callbackStart, true);
+    uint32_t writes = s.getDeadlineWrites();
+
+    s.advance(10);
+    CHECK(countB == 1);
+    CHECK(s.getDeadlineWrites() == writes + 1);
+
+    s.advance(2);
+    CHECK(countA == 2);
+    CHECK(callsA[0] == 11);
+    CHECK(callsA[1] == 12);
+}
+
+// A callback can end the scheduler.
+static void testEndFromCallback() {
+    ZeroTC45Sim s;
+    Scheduler sch(s);
+    reset(s, sch);
+    sch.begin();
+
+    Scheduler::TimerId a = sch.startTimer(10, callbackEnd);
+    sch.startTimer(10, callbackA);
+    s.advance(10);
+    CHECK(countB == 1);
+    CHECK( ! sch.isRunning(a));
+    CHECK( ! s.advanceToDeadline());
+}
+
+int main() {
+    testOrdering();
+    testPeriodicDrift();
+    testStopFromCallback();
+    testStopAfterEnd();
+    testArmOnceFromCallback();
+    testEndFromCallback();
+
+    if (failures != 0) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+
+    printf("All scheduler tests passed\n");
+    return 0;
+}
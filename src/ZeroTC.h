@@ -0,0 +1,134 @@
+/*
+  ZeroTC45 library for Arduino Zero and similar.
+
+  Copyright (c) 2020 David Taylor. All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 3.0 of the License, or (at your option) any later version.
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef ZERO_TC_H
+#define ZERO_TC_H
+
+#include "ZeroTC45.h"
+#include "ZeroTC45Timer.h"
+
+/*
+ * Descriptors of TC4 and TC5 for ZeroTC. Each gives the registers and
+ * interrupt of its TC, and sets up the state the ZeroTC45 interrupt handler
+ * keeps for it.
+ */
+
+/// TC4, run by the ZeroTC45 TC4 methods and interrupt handler.
+struct ZeroTC45Tc4 {
+    static Tc* hw() { return TC4; }
+    static const IRQn_Type irq = TC4_IRQn;
+    static boolean prepare(ZeroTC45& timer, ZeroTC45::ClockConfig config, uint16_t period, boolean oneShot, boolean& interrupt) {
+        return timer.prepareTC(TC4, config, period, oneShot, interrupt);
+    }
+};
+
+/// TC5, run by the ZeroTC45 TC5 methods and interrupt handler.
+struct ZeroTC45Tc5 {
+    static Tc* hw() { return TC5; }
+    static const IRQn_Type irq = TC5_IRQn;
+    static boolean prepare(ZeroTC45& timer, ZeroTC45::ClockConfig config, uint16_t period, boolean oneShot, boolean& interrupt) {
+        return timer.prepareTC(TC5, config, period, oneShot, interrupt);
+    }
+};
+
+/**
+ * Starts and stops TC4 or TC5 with the TC, its interrupt and its resolution
+ * fixed at compile time, eg
+ *
+ *     typedef ZeroTC<ZeroTC45Tc4, ZeroTC45::MILLISECONDS> Timeout;
+ *     Timeout::begin(timer, 50, true);
+ *     ...
+ *     Timeout::start();    // From another interrupt handler.
+ *
+ * begin writes the TC registers with the prescaler of the resolution, worked
+ * out at compile time. After that start, stop and retrigger are inline and
+ * compile to a few register writes to a constant address, with none of the
+ * tests of which TC, which resolution and what has changed that startTc4
+ * makes, so they are quick enough to call from other interrupt handlers.
+ * Each synchronised write polls SYNCBUSY first, so one still being
+ * synchronised doesn't stall the bus.
+ *
+ * The callbacks, statistics and interrupt handler are still those of the
+ * ZeroTC45 object. The period is fixed by begin; call begin again to change
+ * it, or the ZeroTC45 methods for the other modes.
+ */
+template <class TcId, ZeroTC45::Resolution RESOLUTION>
+class ZeroTC {
+
+    // These periods are converted and corrected in the interrupt handler, which the fast path bypasses.
+    static_assert(RESOLUTION != ZeroTC45::CRYSTAL_MILLISECONDS, "ZeroTC periods are whole ticks, use ZeroTC45 for CRYSTAL_MILLISECONDS");
+
+public:
+    /// The TC prescaler setting of the resolution, worked out at compile time.
+    static const uint8_t PRESCALER = ZeroTC45::resolutionConfig(RESOLUTION).prescaler;
+
+    /**
+     * Give the TC the resolution and start it with the period and one-shot
+     * setting. Only the check that the resolution can use the GCLK given to
+     * timer.begin is made at run time. Call this once outside interrupts,
+     * after timer.begin and after the callback is set.
+     *
+     * @param timer The ZeroTC45 object that owns the TC.
+     * @param period The period in ticks of the resolution.
+     * @param oneShot If true the callback will only be called once each start.
+     * @return false if the resolution needs a different GCLK to the one given to timer.begin.
+     */
+    static boolean begin(ZeroTC45& timer, uint16_t period, boolean oneShot = false) {
+        if ( ! TcId::prepare(timer, ZeroTC45::resolutionConfig(RESOLUTION), period, oneShot, interrupt)) {
+            return false;
+        }
+
+        // The overflow is on the count after TOP, so TOP is one less than the period, which is at least 1 as in startTc4.
+        ZeroTC45TimerRegisters::configure(TcId::hw(), PRESCALER, (period == 0) ? 0 : period - 1, oneShot, interrupt);
+        return true;
+    }
+
+    /// Start a new period from zero, or restart a stopped timer or finished one-shot.
+    static inline void start() {
+        Tc* tc = TcId::hw();
+        tc->COUNT16.INTFLAG.reg = TC_INTFLAG_OVF;
+        while (tc->COUNT16.STATUS.bit.SYNCBUSY);
+        tc->COUNT16.CTRLBSET.reg = TC_CTRLBSET_CMD_RETRIGGER;
+        if (interrupt) {
+            tc->COUNT16.INTENSET.reg = TC_INTENSET_OVF;
+            NVIC_EnableIRQ(TcId::irq);
+        }
+    }
+
+    /// Stop the timer. The interrupt is disabled straight away, so no callback is called after this returns.
+    static inline void stop() {
+        Tc* tc = TcId::hw();
+        tc->COUNT16.INTENCLR.reg = TC_INTENCLR_OVF;
+        while (tc->COUNT16.STATUS.bit.SYNCBUSY);
+        tc->COUNT16.CTRLBSET.reg = TC_CTRLBSET_CMD_STOP;
+    }
+
+    /// Start the current period again from zero without touching the interrupt.
+    static inline void retrigger() {
+        Tc* tc = TcId::hw();
+        while (tc->COUNT16.STATUS.bit.SYNCBUSY);
+        tc->COUNT16.CTRLBSET.reg = TC_CTRLBSET_CMD_RETRIGGER;
+    }
+
+private:
+    static boolean interrupt;       // True if begin enabled the overflow interrupt.
+};
+
+template <class TcId, ZeroTC45::Resolution RESOLUTION> boolean ZeroTC<TcId, RESOLUTION>::interrupt = false;
+#endif
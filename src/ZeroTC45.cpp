@@ -18,13 +18,314 @@
 */
 
 #include "ZeroTC45.h"
+#include "ZeroTC45Queue.h"
+#include "ZeroTC45Timer.h"
+#include "wiring_private.h"
 
-static void configureGclk(uint8_t gclkId);
-static void configureTC(Tc* tc, uint16_t period, boolean oneShot);
-static void stopTC(Tc* tc);
+// Built with ZEROTC45_TRACE defined, the interrupt handlers and the start and stop
+// paths add records to ZeroTC45Trace. Otherwise the hooks are empty and cost nothing.
+#if defined(ZEROTC45_TRACE)
+#include "ZeroTC45Trace.h"
+#define TRACE_EVENT(event, tc) ZeroTC45Trace::record(ZeroTC45Trace::event, ((tc) == TC4) ? 4 : 5, readCycles())
+#else
+#define TRACE_EVENT(event, tc)
+#endif
 
-static voidFuncPtr tc4Callback;
-static voidFuncPtr tc5Callback;
+// Built with ZEROTC45_STATS defined, each fire is timed with readCycles for the overruns,
+// missed overflows and longest callback of getTc4Stats, and queued events are stamped
+// with micros(). Otherwise the interrupt handlers don't read the time at all.
+
+// The state of a TC running in tickless mode.
+struct TicklessState {
+    volatile boolean active;
+    volatile boolean armed;         // True while there is a deadline to wait for.
+    volatile uint32_t halfEpochs;   // Incremented at both the overflow and the half-way point of the 16-bit count.
+    volatile uint32_t halfEpochWraps;   // Incremented when halfEpochs wraps, for the 64-bit count.
+    volatile uint32_t deadline;
+    uint8_t leadTicks;              // Minimum distance between the count and a compare value that is sure to be seen.
+    uint16_t compare;               // The CC0 value last written, which can't be read without a read request.
+    boolean compareValid;           // False until CC0 is written after configureTickless.
+};
+
+// The state of a TC in capture mode.
+struct CaptureState {
+    volatile boolean active;
+    volatile boolean fresh;         // True if there is a capture that readTc4Capture hasn't returned.
+    volatile uint16_t period;
+    volatile uint16_t width;
+    uint8_t lastFlag;               // The INTFLAG bit of the compare channel that captures last in each pulse.
+};
+
+// A pin that can be driven by a TC4 or TC5 waveform output, from the peripheral E column of the SAMD21 pin multiplexing table.
+struct PwmPin {
+    uint8_t port;
+    uint8_t pin;
+    uint8_t tc;
+    uint8_t output;
+};
+
+static const PwmPin pwmPins[] = {
+    { PORTA, 22, 4, 0 }, { PORTA, 23, 4, 1 }, { PORTA, 24, 5, 0 }, { PORTA, 25, 5, 1 },
+    { PORTB,  8, 4, 0 }, { PORTB,  9, 4, 1 }, { PORTB, 10, 5, 0 }, { PORTB, 11, 5, 1 },
+    { PORTB, 12, 4, 0 }, { PORTB, 13, 4, 1 }, { PORTB, 14, 5, 0 }, { PORTB, 15, 5, 1 },
+};
+
+// A write to CC0 can take this many TC clocks to synchronise, so a compare
+// value closer than this to the current count may be passed before it takes effect.
+static const uint8_t COMPARE_SYNC_CLOCKS = 8;
+
+
+static boolean validClock(ZeroTC45::ClockConfig config, uint8_t gclkId);
+static void stopTC(Tc* tc, boolean wait);
+static inline void startHeld(Tc* tc);
+static inline void waitSync(Tc* tc);
+static uint32_t readTicks(Tc* tc, TicklessState& state);
+static uint64_t readTicks64(Tc* tc, TicklessState& state);
+static int8_t epochAdjustment(uint32_t half, uint16_t count);
+static void setDeadline(Tc* tc, TicklessState& state, uint32_t deadline);
+static void clearDeadline(Tc* tc, TicklessState& state);
+static void armCompare(Tc* tc, TicklessState& state);
+
+// The callback of a timer. Either function or contextFunction is set, or neither.
+struct TimerCallback {
+    voidFuncPtr function;
+    contextFuncPtr contextFunction;
+    void* context;
+    ZeroTC45Queue* queue;       // If set, an event is pushed here before the callback is called.
+    uint8_t timer;              // The timer number for the queued events.
+    uint32_t count;             // The number of times the timer has fired.
+    uint32_t overruns;
+    uint32_t missed;
+    uint32_t maxCycles;         // The longest callback, in CPU clocks.
+    uint32_t periodCycles;      // The period in CPU clocks, or 0 if fires aren't periodic.
+    uint32_t lastFire;          // readCycles() when the timer last fired or was started.
+
+    // Periods are converted to ticks by multiplying by ticksPerUnit / unitsPerTick, or
+    // used as ticks if unitsPerTick is 0. The fraction of a tick left over each period
+    // is added up in accumulator and an extra tick is added when it reaches a whole one.
+    uint32_t ticksPerUnit;
+    uint32_t unitsPerTick;
+    uint32_t baseTicks;
+    uint32_t remainder;
+    uint32_t accumulator;
+    boolean corrected;          // True if CC0 is rewritten every period with baseTicks plus the correction.
+    boolean wide;               // True for the 32-bit counter.
+
+    // The ratio for the resolution, before the calibration correction is applied.
+    uint32_t resolutionTicks;
+    uint32_t resolutionUnits;
+    int32_t correctionPpb;
+
+    // The period last given, so it can be converted again when the correction changes.
+    uint32_t period;
+    boolean oneShot;
+    uint32_t maxTicks;
+
+    // With deferred set the interrupt only counts the fire, and the callback is called from the deferred interrupt.
+    boolean deferred;
+    volatile uint8_t deferredCalls;
+
+    // The fires left in a burst from startTc4Burst, or 0 if the timer isn't running a burst.
+    volatile uint16_t burstRemaining;
+};
+
+static void handleTicklessInterrupt(Tc* tc, TicklessState& state, TimerCallback& callback);
+static void updateOverflowInterrupt(Tc* tc, TicklessState& state, const TimerCallback& callback);
+static void setCallback(TimerCallback& callback, voidFuncPtr function, contextFuncPtr contextFunction, void* context);
+static void updateEventOutputs(Tc* tc, uint8_t firstGenerator);
+static void releaseInputEvent(Tc* tc);
+static void handleCaptureInterrupt(Tc* tc, CaptureState& capture, TimerCallback& callback);
+static int8_t pwmOutput(Tc* tc, uint8_t pin);
+static void releasePwm(Tc* tc);
+static boolean willFire(Tc* tc, const TicklessState& state, const TimerCallback& callback);
+static uint32_t readCount(Tc* tc, boolean wide);
+static void readContinuously(Tc* tc);
+static uint32_t periodPosition(Tc* tc, const TimerCallback& callback, uint16_t top, boolean remaining);
+static void setTiming(TimerCallback& callback, uint32_t period, uint32_t hz);
+static uint32_t scalePeriod(TimerCallback& callback, uint32_t period, boolean oneShot, uint32_t maxTicks);
+static void setScale(TimerCallback& callback, uint32_t ticksPerUnit, uint32_t unitsPerTick);
+static void setCorrection(TimerCallback& callback, int32_t ppb);
+static void convertPeriod(TimerCallback& callback);
+static ZeroTC45::Stats getStats(const TimerCallback& callback);
+static void resetStats(TimerCallback& callback);
+
+static TimerCallback tc4Callback = { NULL, NULL, NULL, NULL, 4, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, false, false, 0, 0, 0, 0, false, 0, false, 0, 0 };
+static TimerCallback tc5Callback = { NULL, NULL, NULL, NULL, 5, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, false, false, 0, 0, 0, 0, false, 0, false, 0, 0 };
+
+/**
+ * Returns a count of CPU clocks that wraps every 2^32 clocks (89 seconds at
+ * 48MHz). The Cortex-M0+ has no DWT cycle counter, so this is made from the
+ * Arduino millisecond count and SysTick, which counts down from LOAD to 0
+ * once a millisecond.
+ */
+static inline uint32_t readCycles() {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    uint32_t load = SysTick->LOAD + 1;
+    uint32_t ms = millis();
+    uint32_t val = SysTick->VAL;
+
+    // If SysTick has wrapped but its interrupt hasn't run, millis() is a millisecond behind
+    // and val may be from before or after the wrap. Read it again, it's after the wrap now.
+    if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) {
+        val = SysTick->VAL;
+        ms++;
+    }
+
+    __set_PRIMASK(primask);
+    return ms * load + (load - 1 - val);
+}
+
+// The overflow interrupt is needed for a callback, the event queue, or to correct the period.
+static inline boolean hasCallback(const TimerCallback& callback) {
+    return callback.function != NULL || callback.contextFunction != NULL || callback.queue != NULL
+        || callback.corrected;
+}
+
+static inline void callFunction(TimerCallback& callback, uint32_t start);
+
+// readCycles() for the statistics, or 0 without ZEROTC45_STATS so nothing is read.
+static inline uint32_t statsCycles() {
+#if defined(ZEROTC45_STATS)
+    return readCycles();
+#else
+    return 0;
+#endif
+}
+
+static inline void dispatch(TimerCallback& callback) {
+    uint32_t start = statsCycles();
+    callback.count++;
+
+#if defined(ZEROTC45_STATS)
+    if (callback.periodCycles != 0) {
+        // The flag only remembers one overflow, so a gap of several periods means overflows were missed.
+        uint32_t gap = start - callback.lastFire;
+        if (gap > callback.periodCycles + callback.periodCycles / 2) {
+            callback.missed += (gap + callback.periodCycles / 2) / callback.periodCycles - 1;
+        }
+    }
+    callback.lastFire = start;
+#endif
+
+    if (callback.queue != NULL) {
+#if defined(ZEROTC45_STATS)
+        ZeroTC45Event event = { callback.timer, callback.count, micros() };
+#else
+        ZeroTC45Event event = { callback.timer, callback.count, 0 };
+#endif
+        callback.queue->push(event);
+    }
+
+    if (callback.deferred) {
+        // The deferred interrupt calls the callback once for each fire, see ZeroTC45Deferred.cpp.
+        if (callback.deferredCalls == 0xFF) {
+            callback.missed++;
+        } else {
+            callback.deferredCalls++;
+        }
+        NVIC_SetPendingIRQ(ZeroTC45::DEFERRED_IRQn);
+        return;
+    }
+
+    callFunction(callback, start);
+}
+
+/**
+ * Call the callback function of a timer and, with ZEROTC45_STATS, record how long it took.
+ *
+ * @param callback The state of the timer.
+ * @param start statsCycles() when the timer fired.
+ */
+static inline void callFunction(TimerCallback& callback, uint32_t start) {
+    if (callback.contextFunction != NULL) {
+        callback.contextFunction(callback.context);
+    } else if (callback.function != NULL) {
+        callback.function();
+    }
+
+#if defined(ZEROTC45_STATS)
+    uint32_t cycles = readCycles() - start;
+    if (cycles > callback.maxCycles) {
+        callback.maxCycles = cycles;
+    }
+
+    if (callback.periodCycles != 0 && cycles > callback.periodCycles) {
+        callback.overruns++;
+    }
+#else
+    (void)start;
+#endif
+}
+
+/**
+ * Count a fire of a burst. When one fire is left the TC is switched to
+ * one-shot mode, so it stops itself at the end of the last period with no
+ * stop command and no wait. This is a single write to CTRLBSET.
+ */
+static inline void countBurst(Tc* tc, TimerCallback& callback) {
+    if (--callback.burstRemaining == 1) {
+        waitSync(tc);
+        tc->COUNT16.CTRLBSET.reg = TC_CTRLBSET_ONESHOT;
+    }
+}
+
+// The CC0 value last written to TC4 in 32-bit mode.
+static uint32_t tc4Top32;
+
+/**
+ * Set the length of the period that has just started, the base number of
+ * ticks plus one if the fractions of a tick left over from the earlier
+ * periods add up to a whole tick. Called just after the overflow, so the
+ * count is still well below CC0 when the new value takes effect.
+ */
+static inline void correctPeriod(Tc* tc, TimerCallback& callback, uint16_t& top) {
+    uint32_t ticks = callback.baseTicks;
+
+    callback.accumulator += callback.remainder;
+    if (callback.accumulator >= callback.unitsPerTick) {
+        callback.accumulator -= callback.unitsPerTick;
+        ticks++;
+    }
+
+    if (callback.wide) {
+        tc4Top32 = ticks - 1;
+        waitSync(tc);
+        tc->COUNT32.CC[0].reg = tc4Top32;
+    } else if (ticks - 1 != top) {
+        top = ticks - 1;
+        waitSync(tc);
+        tc->COUNT16.CC[0].reg = top;
+    }
+}
+
+static TicklessState tc4Tickless;
+static TicklessState tc5Tickless;
+
+static CaptureState tc4Capture;
+static CaptureState tc5Capture;
+
+// The pins driven by the two waveform outputs, WO0 and WO1, of a TC in PWM mode, -1 if none.
+static int8_t tc4PwmPins[2] = { -1, -1 };
+static int8_t tc5PwmPins[2] = { -1, -1 };
+
+// The NVIC priorities of the TC interrupts, 0 (highest) - 3, from setTc4Priority and setTc5Priority.
+static uint8_t tc4Priority;
+static uint8_t tc5Priority;
+
+// The CC0 value last written by configureTC.
+static uint16_t tc4Top;
+static uint16_t tc5Top;
+
+// The event system channels given out by connectEvent, and what they connect.
+static uint16_t usedEventChannels;
+static uint8_t eventGenerators[EVSYS_CHANNELS];
+static uint8_t eventUsers[EVSYS_CHANNELS];
+
+// The event channels connected to the TC event inputs by startTc4OnEvent or startTc4Capture, -1 if none.
+static int8_t tc4InputChannel = -1;
+static int8_t tc5InputChannel = -1;
 
 /**
  * Initialises the library with a resolution of seconds.
@@ -33,57 +334,384 @@ static voidFuncPtr tc5Callback;
  * it just seems to be free on Arduinos and similar systems.
  *
  * @param gclkId The ID of the GCLK clock source to use as input for TC4 and TC5. Defaults to 4.
+ * @return false if the GCLK can't be used, see begin(ClockConfig, ClockConfig, uint8_t).
  */
-void ZeroTC45::begin(uint8_t gclkId) {
-    resolution = SECONDS;
-    configureGclk(gclkId);
-
-    // Enable TC4 & TC5 in the power manager.
-    PM->APBCMASK.reg |= PM_APBCMASK_TC4;
-    PM->APBCMASK.reg |= PM_APBCMASK_TC5;
+boolean ZeroTC45::begin(uint8_t gclkId) {
+    return begin(resolutionConfig(SECONDS), gclkId);
 }
 
 /**
  * Initialises the library with the given resolution.
  *
+ * MILLISECONDS ticks at 1024Hz from OSCULP32K, SECONDS ticks at 1Hz from
+ * XOSC32K and MICROSECONDS ticks at 1MHz from DFLL48M.
+ *
+ * CRYSTAL_MILLISECONDS ticks at 1024Hz from XOSC32K and periods are given in
+ * milliseconds. Each period is a whole number of ticks, and the fraction of
+ * a tick left over is carried into the later periods, so the long term
+ * rate is as exact as the crystal. Periods must be at least 8ms for the
+ * correction to be applied, and at most 63999ms.
+ *
  * Uses GCLK 4 by default. GLCK id 4 is no relationship with TC4,
  * it just seems to be free on Arduinos and similar systems.
  *
  * @param gclkId The ID of the GCLK clock source to use as input for TC4 and TC5. Defaults to 4.
+ * @return false if the GCLK can't be used, see begin(ClockConfig, ClockConfig, uint8_t).
+ */
+boolean ZeroTC45::begin(Resolution resolution, uint8_t gclkId) {
+    return begin(resolution, resolution, gclkId);
+}
+
+/**
+ * Initialises the library with the given clock configuration, for tick rates
+ * the Resolution values don't cover. Make the configuration with tickRate
+ * or ZeroTC45TickRate so the divisors are worked out at compile time, eg
+ * ZeroTC45TickRate<100000>::config() for 10us ticks.
+ *
+ * DFLL48M is the CPU clock so is always running. OSC8M is enabled if it
+ * isn't already.
+ *
+ * @param config The clock source, GCLK divisor and TC prescaler to use.
+ * @param gclkId The ID of the GCLK clock source to use as input for TC4 and TC5. Defaults to 4.
+ * @return false if the configuration isn't valid, see begin(ClockConfig, ClockConfig, uint8_t).
+ */
+boolean ZeroTC45::begin(ClockConfig config, uint8_t gclkId) {
+    return begin(config, config, gclkId);
+}
+
+/**
+ * Initialises the library with a different resolution for each timer, eg
+ * MILLISECONDS on TC4 for scheduling and SECONDS on TC5 for a slow heartbeat.
+ *
+ * TC4 and TC5 share a GCLK so only the TC prescalers differ. MILLISECONDS and
+ * SECONDS together both run from XOSC32K. MICROSECONDS uses a different GCLK
+ * divisor so can't be mixed with the other resolutions.
+ *
+ * @param tc4Resolution The resolution of TC4, and of the chained 32-bit counter.
+ * @param tc5Resolution The resolution of TC5.
+ * @param gclkId The ID of the GCLK clock source to use as input for TC4 and TC5. Defaults to 4.
+ * @return true if the resolutions can be used together, otherwise false and nothing is changed.
+ */
+boolean ZeroTC45::begin(Resolution tc4Resolution, Resolution tc5Resolution, uint8_t gclkId) {
+    ClockConfig tc4Config = resolutionConfig(tc4Resolution);
+    ClockConfig tc5Config = resolutionConfig(tc5Resolution);
+
+    // The 32kHz oscillators give the same GCLK, so use the crystal for both.
+    if (tc4Config.source != tc5Config.source && tc4Config.source != DFLL48M && tc5Config.source != DFLL48M) {
+        tc4Config.source = XOSC32K;
+        tc5Config.source = XOSC32K;
+    }
+
+    if ( ! begin(tc4Config, tc5Config, gclkId)) {
+        return false;
+    }
+
+    // The 1024Hz crystal ticks are scaled to milliseconds.
+    if (tc4Resolution == CRYSTAL_MILLISECONDS) {
+        setScale(tc4Callback, 1024, 1000);
+    }
+
+    if (tc5Resolution == CRYSTAL_MILLISECONDS) {
+        setScale(tc5Callback, 1024, 1000);
+    }
+
+    return true;
+}
+
+/**
+ * Initialises the library with a different clock configuration for each timer.
+ *
+ * TC4 and TC5 share a GCLK so the configurations must have the same source and
+ * GCLK divisor, and differ only in the TC prescaler.
+ *
+ * The configurations are checked before anything is written. The GCLK must
+ * be 1 - 8, as GCLK 0 is the CPU clock, and the divisor must fit its DIV
+ * field: up to 31 for GCLK 2, 65535 for GCLK 1 and 255 for the others. The
+ * divisor must not be 0 and the tick rate must be at least 1Hz.
+ *
+ * @param tc4Config The clock configuration of TC4, and of the chained 32-bit counter.
+ * @param tc5Config The clock configuration of TC5.
+ * @param gclkId The ID of the GCLK clock source to use as input for TC4 and TC5. Defaults to 4.
+ * @return true if the configurations are valid and can be used together, otherwise false and nothing is changed.
  */
-void ZeroTC45::begin(Resolution resolution, uint8_t gclkId) {
-    this->resolution = resolution;
+boolean ZeroTC45::begin(ClockConfig tc4Config, ClockConfig tc5Config, uint8_t gclkId) {
+    if (tc4Config.source != tc5Config.source || tc4Config.gclkDivisor != tc5Config.gclkDivisor) {
+        return false;
+    }
+
+    if ( ! validClock(tc4Config, gclkId) || ! validClock(tc5Config, gclkId)) {
+        return false;
+    }
+
+    clock = tc4Config;
+    tc5Prescaler = tc5Config.prescaler;
+    this->gclkId = gclkId;
     configureGclk(gclkId);
 
+    // Periods are in ticks.
+    setScale(tc4Callback, 0, 0);
+    setScale(tc5Callback, 0, 0);
+
     // Enable TC4 & TC5 in the power manager.
     PM->APBCMASK.reg |= PM_APBCMASK_TC4;
     PM->APBCMASK.reg |= PM_APBCMASK_TC5;
+
+    return true;
+}
+
+/**
+ * Returns the TC4 clock configuration given to begin, eg to find the tick rate with tickHz.
+ */
+ZeroTC45::ClockConfig ZeroTC45::getClockConfig() {
+    return clock;
+}
+
+/**
+ * Returns the TC5 clock configuration given to begin. This is the same as
+ * getClockConfig unless the timers were given different resolutions.
+ */
+ZeroTC45::ClockConfig ZeroTC45::getTc5ClockConfig() {
+    ClockConfig config = clock;
+    config.prescaler = tc5Prescaler;
+    return config;
+}
+
+/**
+ * Returns the GCLK given to begin. ZeroTC45Timer connects the clocks of TC3
+ * and the TCCs to it, so all the timers share its source and divisor.
+ */
+uint8_t ZeroTC45::getGclkId() {
+    return gclkId;
+}
+
+/**
+ * Change the resolution of both timers at run time, eg from MILLISECONDS
+ * while sampling to SECONDS while idle. Both timers are stopped first, then
+ * the clocks are set up as begin(tc4Resolution, tc5Resolution) would with
+ * the same GCLK, which only writes the registers that change. Start the
+ * timers again with periods in the new units.
+ *
+ * The calibration corrections are kept if the clock source doesn't change.
+ *
+ * begin must have been called first.
+ *
+ * @param tc4Resolution The new resolution of TC4, and of the chained 32-bit counter.
+ * @param tc5Resolution The new resolution of TC5.
+ * @return true if the resolutions can be used together, otherwise false and only the timers are stopped.
+ */
+boolean ZeroTC45::setResolution(Resolution tc4Resolution, Resolution tc5Resolution) {
+    stopTC(TC4, false);
+    stopTC(TC5, true);
+
+    ClockSource source = clock.source;
+    int32_t tc4Ppb = tc4Callback.correctionPpb;
+    int32_t tc5Ppb = tc5Callback.correctionPpb;
+
+    if ( ! begin(tc4Resolution, tc5Resolution, gclkId)) {
+        return false;
+    }
+
+    if (clock.source == source) {
+        setCorrection(tc4Callback, tc4Ppb);
+        setCorrection(tc5Callback, tc5Ppb);
+    }
+
+    return true;
+}
+
+/**
+ * Change the resolution of both timers to the same one. See setResolution(Resolution, Resolution).
+ *
+ * @param resolution The new resolution of TC4 and TC5.
+ * @return true if the clocks were changed.
+ */
+boolean ZeroTC45::setResolution(Resolution resolution) {
+    return setResolution(resolution, resolution);
+}
+
+/**
+ * Change the resolution of TC4 by changing only its prescaler, so the GCLK
+ * and TC5 carry on undisturbed. This works between the resolutions with the
+ * same GCLK divisor: SECONDS, MILLISECONDS and CRYSTAL_MILLISECONDS. The
+ * 32kHz oscillators are treated as the same clock, so the one already in use
+ * is kept, eg SECONDS on OSCULP32K after begin(MILLISECONDS).
+ *
+ * TC4 is stopped first. The new prescaler is written when it is started again
+ * with a period in the new units. The calibration correction is kept.
+ *
+ * @param resolution The new resolution of TC4.
+ * @return true if the resolution was changed, false if it needs a different GCLK, eg MICROSECONDS.
+ */
+boolean ZeroTC45::setTc4Resolution(Resolution resolution) {
+    return changePrescaler(TC4, resolution);
+}
+
+/**
+ * Change the resolution of TC5 by changing only its prescaler. See setTc4Resolution.
+ *
+ * @param resolution The new resolution of TC5.
+ * @return true if the resolution was changed, false if it needs a different GCLK, eg MICROSECONDS.
+ */
+boolean ZeroTC45::setTc5Resolution(Resolution resolution) {
+    return changePrescaler(TC5, resolution);
 }
 
 /**
  * This function will be called every time the TC4 counter
  * overflows the period value given to startTc4.
  *
- * If set to NULL the interrupt service routine will
- * not make a callback.
+ * If set to NULL the overflow interrupt is disabled, eg when the overflow
+ * is only used as an event routed with routeTc4Event.
  *
  * @param callback The function to call when the overflow interrupt occurs.
  */
 void ZeroTC45::setTc4Callback(voidFuncPtr callback) {
-    tc4Callback = callback;
+    setCallback(tc4Callback, callback, NULL, NULL);
+    updateOverflowInterrupt(TC4, tc4Tickless, tc4Callback);
 }
 
 /**
  * This function will be called every time the TC5 counter
  * overflows the period value given to startTc5.
  *
- * If set to NULL the interrupt service routine will
- * not make a callback.
+ * If set to NULL the overflow interrupt is disabled, eg when the overflow
+ * is only used as an event routed with routeTc5Event.
  *
  * @param callback The function to call when the overflow interrupt occurs.
  */
 void ZeroTC45::setTc5Callback(voidFuncPtr callback) {
-    tc5Callback = callback;
+    setCallback(tc5Callback, callback, NULL, NULL);
+    updateOverflowInterrupt(TC5, tc5Tickless, tc5Callback);
+}
+
+/**
+ * Set a TC4 callback that is given a context pointer, eg the object that
+ * handles the timer, so it doesn't need global state. This replaces a
+ * callback set with setTc4Callback(voidFuncPtr).
+ *
+ * If callback is NULL the overflow interrupt is disabled.
+ *
+ * @param callback The function to call when the overflow interrupt occurs.
+ * @param context The pointer to pass to the callback.
+ */
+void ZeroTC45::setTc4Callback(contextFuncPtr callback, void* context) {
+    setCallback(tc4Callback, NULL, callback, context);
+    updateOverflowInterrupt(TC4, tc4Tickless, tc4Callback);
+}
+
+/**
+ * Set a TC5 callback that is given a context pointer. See setTc4Callback(contextFuncPtr, void*).
+ *
+ * @param callback The function to call when the overflow interrupt occurs.
+ * @param context The pointer to pass to the callback.
+ */
+void ZeroTC45::setTc5Callback(contextFuncPtr callback, void* context) {
+    setCallback(tc5Callback, NULL, callback, context);
+    updateOverflowInterrupt(TC5, tc5Tickless, tc5Callback);
+}
+
+/**
+ * Push an event to queue every time TC4 fires, before the callback is
+ * called. The callback may be NULL when only the queue is used, so the
+ * interrupt handler does no more than push the event and loop() drains the
+ * queue.
+ *
+ * @param queue The queue to push to, or NULL to stop queueing.
+ */
+void ZeroTC45::setTc4Queue(ZeroTC45Queue* queue) {
+    tc4Callback.queue = queue;
+    updateOverflowInterrupt(TC4, tc4Tickless, tc4Callback);
+}
+
+/**
+ * Push an event to queue every time TC5 fires. See setTc4Queue.
+ *
+ * @param queue The queue to push to, or NULL to stop queueing.
+ */
+void ZeroTC45::setTc5Queue(ZeroTC45Queue* queue) {
+    tc5Callback.queue = queue;
+    updateOverflowInterrupt(TC5, tc5Tickless, tc5Callback);
+}
+
+/**
+ * Returns the TC4 statistics since it was started or resetTc4Stats was
+ * called. This also covers the 32-bit counter and tickless mode.
+ *
+ * fires counts every time the timer fired. overruns counts callbacks that
+ * took longer than the period. missed counts overflows that were lost
+ * because the interrupt was handled too late (eg a long callback or
+ * interrupts disabled) so one flag stood for several overflows, or in
+ * tickless mode the deadlines reached late. maxCallbackCycles is the
+ * longest callback, including the event queue push, in CPU clocks.
+ *
+ * Periods longer than about 44 seconds (2^31 CPU clocks) are not checked
+ * for overruns or missed overflows.
+ *
+ * Timing the callbacks costs two reads of the time in every interrupt, so
+ * overruns, maxCallbackCycles and the late overflows in missed are only
+ * counted when the library is built with ZEROTC45_STATS defined. Without it
+ * they stay 0, except the tickless deadlines and deferred calls in missed.
+ */
+ZeroTC45::Stats ZeroTC45::getTc4Stats() {
+    return getStats(tc4Callback);
+}
+
+/**
+ * Returns the TC5 statistics. See getTc4Stats.
+ */
+ZeroTC45::Stats ZeroTC45::getTc5Stats() {
+    return getStats(tc5Callback);
+}
+
+/**
+ * Set all the TC4 statistics to zero.
+ */
+void ZeroTC45::resetTc4Stats() {
+    resetStats(tc4Callback);
+}
+
+/**
+ * Set all the TC5 statistics to zero.
+ */
+void ZeroTC45::resetTc5Stats() {
+    resetStats(tc5Callback);
+}
+
+/**
+ * Correct the TC4 periods for the error of its clock, eg as measured by
+ * ZeroTC45Calibrator. Each period is made longer or shorter by the fraction
+ * of a tick needed, with the fractions carried from period to period, so
+ * the long term rate is right to about 1 part per billion. A running timer
+ * uses the correction from its next period.
+ *
+ * The correction is made by rewriting CC0 at each overflow, so it applies to
+ * periodic timers of at least 8 ticks, not to one-shots or tickless mode.
+ * begin clears the correction.
+ *
+ * @param ppb How fast the clock runs in parts per billion, positive if it is fast. 0 for no correction.
+ */
+void ZeroTC45::setTc4Correction(int32_t ppb) {
+    setCorrection(tc4Callback, ppb);
+    updateOverflowInterrupt(TC4, tc4Tickless, tc4Callback);
+}
+
+/**
+ * Correct the TC5 periods for the error of its clock. See setTc4Correction.
+ *
+ * @param ppb How fast the clock runs in parts per billion, positive if it is fast. 0 for no correction.
+ */
+void ZeroTC45::setTc5Correction(int32_t ppb) {
+    setCorrection(tc5Callback, ppb);
+    updateOverflowInterrupt(TC5, tc5Tickless, tc5Callback);
+}
+
+/**
+ * Returns a count of CPU clocks, the same one used for the statistics. It
+ * wraps every 2^32 clocks (89 seconds at 48MHz) so compare counts by
+ * subtracting them. Useful for measuring short times, eg in benchmarks.
+ */
+uint32_t ZeroTC45::getCycles() {
+    return readCycles();
 }
 
 /**
@@ -98,7 +726,7 @@ void ZeroTC45::setTc5Callback(voidFuncPtr callback) {
  * @param oneShot If true the callback will only be called once.
  */
 void ZeroTC45::startTc4(uint16_t period, boolean oneShot) {
-    configureTC(TC4, period, oneShot);
+    configureTC(TC4, period, oneShot, true);
 }
 
 /**
@@ -113,110 +741,1719 @@ void ZeroTC45::startTc4(uint16_t period, boolean oneShot) {
  * @param oneShot If true the callback will only be called once.
  */
 void ZeroTC45::startTc5(uint16_t period, boolean oneShot) {
-    configureTC(TC5, period, oneShot);
+    configureTC(TC5, period, oneShot, true);
 }
 
 /**
- * Stop TC4, clear pending interrupts, disable interrupts.
+ * Start TC4 for a burst of count fires, period apart, after which it stops
+ * by itself. The callback doesn't need to count the fires or call stopTc4,
+ * which would wait for the stop command to synchronise in the interrupt.
+ *
+ * The interrupt handler counts the fires down, and before the last one
+ * switches TC4 to one-shot mode with a single register write, so the TC
+ * stops at the end of the last period. The period must be longer than a few
+ * ticks for the write to take effect in time.
+ *
+ * @param period The time between fires, in the units of the TC4 resolution.
+ * @param count The number of fires. 1 is the same as a one-shot, and 0 stops TC4.
  */
-void ZeroTC45::stopTc4() {
-    stopTC(TC4);
+void ZeroTC45::startTc4Burst(uint16_t period, uint16_t count) {
+    configureBurst(TC4, period, count);
 }
 
 /**
- * Stop TC5, clear pending interrupts, disable interrupts.
+ * Start TC5 for a burst of count fires, period apart, after which it stops
+ * by itself. See startTc4Burst.
+ *
+ * @param period The time between fires, in the units of the TC5 resolution.
+ * @param count The number of fires. 1 is the same as a one-shot, and 0 stops TC5.
  */
-void ZeroTC45::stopTc5() {
-    stopTC(TC5);
+void ZeroTC45::startTc5Burst(uint16_t period, uint16_t count) {
+    configureBurst(TC5, period, count);
 }
 
 /**
- * Stop a TC by giving it a stop command, disabling the TC overflow interrupt, and
- * clearing and disabling the TC-specific interrupt line.
- *
- * @param tc The TC to configure, must be TC4 or TC5.
+ * Returns the number of fires left in the TC4 burst, or 0 if TC4 isn't running a burst.
  */
-void stopTC(Tc* tc) {
-    while (tc->COUNT16.STATUS.bit.SYNCBUSY);
-    tc->COUNT16.CTRLBSET.reg |= TC_CTRLBSET_CMD_STOP;
-    while (tc->COUNT16.STATUS.bit.SYNCBUSY);
-
-    while (tc->COUNT16.STATUS.bit.SYNCBUSY);
-    tc->COUNT16.INTENCLR.bit.OVF = 1;
-    while (tc->COUNT16.STATUS.bit.SYNCBUSY);
+uint16_t ZeroTC45::getTc4BurstRemaining() {
+    return tc4Callback.burstRemaining;
+}
 
-    if (tc == TC4) {
-        NVIC_ClearPendingIRQ(TC4_IRQn);
-        NVIC_DisableIRQ (TC4_IRQn);
-    } else if (tc == TC5) {
-        NVIC_ClearPendingIRQ(TC5_IRQn);
-        NVIC_DisableIRQ (TC5_IRQn);
-    }
+/**
+ * Returns the number of fires left in the TC5 burst, or 0 if TC5 isn't running a burst.
+ */
+uint16_t ZeroTC45::getTc5BurstRemaining() {
+    return tc5Callback.burstRemaining;
 }
 
 /**
- * Configure the given TC (must be TC4 or TC5) to count in seconds and
- * cause a match interrupt at matchValue seconds.
+ * Start TC4 and TC5 together, so their periods start on the same tick. Both
+ * TCs are set up first and left waiting, and then started with one
+ * synchronised write each, made back to back. TC4 and TC5 share a GCLK, so
+ * the two writes synchronise on the same TC clock.
  *
- * @param tc The TC to configure, must be TC4 or TC5.
- * @param period The amount of time in seconds between overflow interrupts.
- * @param oneShot If true then the TC one-shot mode is enabled.
+ * Starting them with startTc4 and then startTc5 would leave TC5 behind by
+ * all the synchronisation waits of startTc4.
+ *
+ * @param tc4Period The TC4 period, in the units of the TC4 resolution.
+ * @param tc5Period The TC5 period, in the units of the TC5 resolution.
+ * @param oneShot If true both TCs only fire once.
  */
-void ZeroTC45::configureTC(Tc* tc, uint16_t period, boolean oneShot) {
+void ZeroTC45::startBoth(uint16_t tc4Period, uint16_t tc5Period, boolean oneShot) {
+    configureTC(TC4, tc4Period, oneShot, true, true);
+    configureTC(TC5, tc5Period, oneShot, true, true);
 
-    // Disable TC so it can be configured.
-    while (tc->COUNT16.STATUS.bit.SYNCBUSY);
-    tc->COUNT16.CTRLA.reg &= ~TC_CTRLA_ENABLE;
-    while (tc->COUNT16.STATUS.bit.SYNCBUSY);
+    // Nothing is being synchronised now, so neither write stalls.
+    startHeld(TC4);
+    startHeld(TC5);
 
-    uint16_t ctrla = TC_CTRLA_MODE_COUNT16        // Use 16-bit counting mode.
-                   | TC_CTRLA_WAVEGEN(1)          // Use MFRQ mode so CC0 is 'TOP' and we get an overflow every time CC0 is reached.
-                   | TC_CTRLA_RUNSTDBY;           // Run when in standby mode.
+    // Traced after both starts so the trace doesn't delay TC5.
+    TRACE_EVENT(START, TC4);
+    TRACE_EVENT(START, TC5);
 
-    if (resolution == SECONDS) {
-        ctrla |= TC_CTRLA_PRESCALER_DIV1024;      // Divide the input GCLK frequency by 1024.
-    }
-    
-    tc->COUNT16.CTRLA.reg = ctrla;
-    while (tc->COUNT16.STATUS.bit.SYNCBUSY);
+    while (TC4->COUNT16.STATUS.bit.SYNCBUSY || TC5->COUNT16.STATUS.bit.SYNCBUSY);
+}
 
-    // In MFRQ mode, one-shot works and will only generate one overflow interrupt.
-    if (oneShot) {
-        tc->COUNT16.CTRLBSET.bit.ONESHOT = 1;
-        while (tc->COUNT16.STATUS.bit.SYNCBUSY);
+/**
+ * Start TC4 in the same way as startTc4, but return as soon as the write
+ * that starts it has been issued instead of waiting for the TC to start.
+ *
+ * Restarting TC4 with the same period and one-shot setting as last time
+ * only takes one synchronised write, so this returns almost immediately.
+ * Otherwise the writes before the last one are waited for, with interrupts
+ * enabled, which takes a few TC clocks each. Use isTc4SyncBusy to see when
+ * the TC has started.
+ *
+ * @param period The amount of time in seconds between calls to the callback function.
+ * @param oneShot If true the callback will only be called once.
+ */
+void ZeroTC45::startTc4Async(uint16_t period, boolean oneShot) {
+    configureTC(TC4, period, oneShot, false);
+}
+
+/**
+ * Start TC5 in the same way as startTc5, but return as soon as the register
+ * writes have been issued. See startTc4Async.
+ *
+ * @param period The amount of time in seconds between calls to the callback function.
+ * @param oneShot If true the callback will only be called once.
+ */
+void ZeroTC45::startTc5Async(uint16_t period, boolean oneShot) {
+    configureTC(TC5, period, oneShot, false);
+}
+
+/**
+ * Stop TC4, clear pending interrupts, disable interrupts.
+ */
+void ZeroTC45::stopTc4() {
+    stopTC(TC4, true);
+}
+
+/**
+ * Stop TC5, clear pending interrupts, disable interrupts.
+ */
+void ZeroTC45::stopTc5() {
+    stopTC(TC5, true);
+}
+
+/**
+ * Stop TC4 without waiting for the stop command to be synchronised. The TC4
+ * interrupt is disabled before this returns so there will be no more callbacks.
+ */
+void ZeroTC45::stopTc4Async() {
+    stopTC(TC4, false);
+}
+
+/**
+ * Stop TC5 without waiting for the stop command to be synchronised. The TC5
+ * interrupt is disabled before this returns so there will be no more callbacks.
+ */
+void ZeroTC45::stopTc5Async() {
+    stopTC(TC5, false);
+}
+
+/**
+ * Restart the TC4 count from zero with a retrigger command, keeping the
+ * period and one-shot setting given to startTc4. A one-shot that has
+ * already fired is started again.
+ *
+ * This is a single register write, so it is cheap enough for debounce and
+ * inactivity timeouts. It does nothing useful if TC4 has not been started
+ * with startTc4, or has been stopped with stopTc4 (which disables the
+ * interrupt); use startTc4 in those cases.
+ */
+void ZeroTC45::retriggerTc4() {
+    waitSync(TC4);
+    TC4->COUNT16.CTRLBSET.reg = TC_CTRLBSET_CMD_RETRIGGER;
+    TRACE_EVENT(START, TC4);
+    tc4Callback.lastFire = statsCycles();
+}
+
+/**
+ * Restart the TC5 count from zero with a retrigger command. See retriggerTc4.
+ */
+void ZeroTC45::retriggerTc5() {
+    waitSync(TC5);
+    TC5->COUNT16.CTRLBSET.reg = TC_CTRLBSET_CMD_RETRIGGER;
+    TRACE_EVENT(START, TC5);
+    tc5Callback.lastFire = statsCycles();
+}
+
+/**
+ * Change the TC4 period by writing only CC0. The count is not restarted.
+ *
+ * The SAMD21 TC has no buffer for CC0 so the new period takes effect as
+ * soon as the write is synchronised. If the count is already past the new
+ * period it will count up to 0xFFFF and wrap before the next overflow, so
+ * call retriggerTc4 afterwards if the period is being shortened.
+ *
+ * @param period The new amount of time between calls to the callback function.
+ */
+void ZeroTC45::updatePeriodTc4(uint16_t period) {
+    tc4Top = scalePeriod(tc4Callback, period, false, 0xFFFF) - 1;
+    waitSync(TC4);
+    TC4->COUNT16.CC[0].reg = tc4Top;
+    setTiming(tc4Callback, period, timingHz(TC4));
+}
+
+/**
+ * Change the TC5 period by writing only CC0. See updatePeriodTc4.
+ *
+ * @param period The new amount of time between calls to the callback function.
+ */
+void ZeroTC45::updatePeriodTc5(uint16_t period) {
+    tc5Top = scalePeriod(tc5Callback, period, false, 0xFFFF) - 1;
+    waitSync(TC5);
+    TC5->COUNT16.CC[0].reg = tc5Top;
+    setTiming(tc5Callback, period, timingHz(TC5));
+}
+
+/**
+ * Returns true while a write to TC4 is still being synchronised, eg after
+ * startTc4Async or stopTc4Async.
+ */
+boolean ZeroTC45::isTc4SyncBusy() {
+    return TC4->COUNT16.STATUS.bit.SYNCBUSY;
+}
+
+/**
+ * Returns true while a write to TC5 is still being synchronised, eg after
+ * startTc5Async or stopTc5Async.
+ */
+boolean ZeroTC45::isTc5SyncBusy() {
+    return TC5->COUNT16.STATUS.bit.SYNCBUSY;
+}
+
+/**
+ * Start TC4 and TC5 as a single 32-bit counter. It will cause an interrupt
+ * every period ticks and the TC4 callback function given to setTc4Callback
+ * will be called each time.
+ *
+ * TC4 is the master and TC5 is the slave, so while the counters are chained
+ * TC5 cannot be used on its own and startTc4, startTc5 and the tickless
+ * methods must not be called until stopTc45_32 has been called.
+ *
+ * In MILLISECONDS resolution the period can be up to about 49 days.
+ *
+ * @param period The amount of time between calls to the callback function, in ticks of the resolution given to begin.
+ * @param oneShot If true the callback will only be called once.
+ */
+void ZeroTC45::startTc45_32(uint32_t period, boolean oneShot) {
+    configureTC32(period, oneShot);
+}
+
+/**
+ * Stop the chained 32-bit counter. TC4 is disabled and put back into 16-bit
+ * mode so TC4 and TC5 can be used on their own again.
+ */
+void ZeroTC45::stopTc45_32() {
+    stopTC(TC4, false);
+
+    // Disabling the TC also stops it, and the mode can only be changed once it is disabled.
+    TC4->COUNT32.CTRLA.reg &= ~TC_CTRLA_ENABLE;
+    while (TC4->COUNT32.STATUS.bit.SYNCBUSY);
+
+    // Leaving COUNT32 mode releases TC5 from being the slave.
+    waitSync(TC4);
+    TC4->COUNT16.CTRLA.reg = TC_CTRLA_MODE_COUNT16;
+}
+
+/**
+ * Start TC4 counting freely in tickless mode.
+ *
+ * TC4 counts through its full 16-bit range, and the overflow and half-way
+ * point of the count are used to extend the count to 32 bits. There is no
+ * periodic callback. Instead, the TC4 callback is called once when the
+ * count reaches the deadline given to setTc4Deadline, so there is only an
+ * interrupt when something is due (plus two per 65536 ticks to extend the count).
+ *
+ * The count is in ticks of the resolution given to begin. Call stopTc4 to
+ * leave tickless mode.
+ */
+void ZeroTC45::startTc4Tickless() {
+    configureTickless(TC4);
+}
+
+/**
+ * Start TC5 counting freely in tickless mode. See startTc4Tickless.
+ */
+void ZeroTC45::startTc5Tickless() {
+    configureTickless(TC5);
+}
+
+/**
+ * Returns the TC4 tickless count. This wraps around, so compare
+ * counts by subtracting them.
+ */
+uint32_t ZeroTC45::getTc4Ticks() {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t ticks = readTicks(TC4, tc4Tickless);
+    __set_PRIMASK(primask);
+    return ticks;
+}
+
+/**
+ * Returns the TC5 tickless count. This wraps around, so compare
+ * counts by subtracting them.
+ */
+uint32_t ZeroTC45::getTc5Ticks() {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t ticks = readTicks(TC5, tc5Tickless);
+    __set_PRIMASK(primask);
+    return ticks;
+}
+
+/**
+ * Returns the TC4 tickless count as 64 bits, so it never wraps. This doesn't
+ * disable interrupts, and can be called from an interrupt.
+ */
+uint64_t ZeroTC45::getTc4Ticks64() {
+    return readTicks64(TC4, tc4Tickless);
+}
+
+/**
+ * Returns the TC5 tickless count as 64 bits, so it never wraps. This doesn't
+ * disable interrupts, and can be called from an interrupt.
+ */
+uint64_t ZeroTC45::getTc5Ticks64() {
+    return readTicks64(TC5, tc5Tickless);
+}
+
+/**
+ * Returns how long it is since the TC4 period started, or since startTc4 for
+ * a one-shot, in the units of the period given to startTc4. The count is
+ * read continuously, so this doesn't wait for a read request to synchronise
+ * and is cheap enough to call in a loop, but lags by a few TC clocks.
+ *
+ * Returns 0 if TC4 is stopped, a one-shot has finished, or TC4 is in
+ * tickless or capture mode. Use getTc4Ticks in tickless mode.
+ */
+uint32_t ZeroTC45::elapsedTc4() {
+    return periodPosition(TC4, tc4Callback, tc4Top, false);
+}
+
+/**
+ * Returns how long it is until the TC4 callback is next called, in the units
+ * of the period given to startTc4. See elapsedTc4.
+ */
+uint32_t ZeroTC45::remainingTc4() {
+    return periodPosition(TC4, tc4Callback, tc4Top, true);
+}
+
+/**
+ * Returns how long it is since the TC5 period started, or since startTc5 for
+ * a one-shot, in the units of the period given to startTc5. See elapsedTc4.
+ */
+uint32_t ZeroTC45::elapsedTc5() {
+    return periodPosition(TC5, tc5Callback, tc5Top, false);
+}
+
+/**
+ * Returns how long it is until the TC5 callback is next called, in the units
+ * of the period given to startTc5. See elapsedTc4.
+ */
+uint32_t ZeroTC45::remainingTc5() {
+    return periodPosition(TC5, tc5Callback, tc5Top, true);
+}
+
+/**
+ * Call the TC4 callback when the TC4 tickless count reaches deadline. This
+ * replaces any deadline already set, and may be called from the callback to
+ * set the next deadline.
+ *
+ * A deadline that is due within a few ticks may be late by those few
+ * ticks, because the TC needs time to synchronise the new compare value.
+ *
+ * @param deadline The tick count to call the callback at, less than 2^31 ticks from now.
+ */
+void ZeroTC45::setTc4Deadline(uint32_t deadline) {
+    setDeadline(TC4, tc4Tickless, deadline);
+}
+
+/**
+ * Call the TC5 callback when the TC5 tickless count reaches deadline. See setTc4Deadline.
+ *
+ * @param deadline The tick count to call the callback at, less than 2^31 ticks from now.
+ */
+void ZeroTC45::setTc5Deadline(uint32_t deadline) {
+    setDeadline(TC5, tc5Tickless, deadline);
+}
+
+/**
+ * Cancel the TC4 deadline so the callback is not called. TC4 keeps counting.
+ */
+void ZeroTC45::clearTc4Deadline() {
+    clearDeadline(TC4, tc4Tickless);
+}
+
+/**
+ * Cancel the TC5 deadline so the callback is not called. TC5 keeps counting.
+ */
+void ZeroTC45::clearTc5Deadline() {
+    clearDeadline(TC5, tc5Tickless);
+}
+
+/**
+ * Route a TC4 event through the event system to a peripheral, so the
+ * peripheral is triggered by the hardware without an interrupt. For example
+ * routeTc4Event(ZeroTC45::OVERFLOW_EVENT, EVSYS_ID_USER_ADC_START) starts an
+ * ADC conversion every period, with no jitter from other interrupts.
+ *
+ * In the periodic modes CC0 is the period so MATCH0_EVENT happens at the same
+ * time as OVERFLOW_EVENT. In tickless mode MATCH0_EVENT happens at the
+ * deadline. The peripheral has to be set up to act on the event, eg with
+ * ADC EVCTRL.STARTEI.
+ *
+ * If the callback is NULL the overflow interrupt is not enabled, so the TC
+ * runs without any CPU involvement.
+ *
+ * @param event The TC4 event to route.
+ * @param user The EVSYS_ID_USER_ value of the peripheral to trigger.
+ * @return The event channel used, for unrouteTc4Event, or -1 if there are no free channels.
+ */
+int8_t ZeroTC45::routeTc4Event(TcEvent event, uint8_t user) {
+    int8_t channel = connectEvent(EVSYS_ID_GEN_TC4_OVF + event, user);
+    if (channel >= 0) {
+        updateEventOutputs(TC4, EVSYS_ID_GEN_TC4_OVF);
+    }
+    return channel;
+}
+
+/**
+ * Route a TC5 event through the event system to a peripheral. See routeTc4Event.
+ *
+ * @param event The TC5 event to route.
+ * @param user The EVSYS_ID_USER_ value of the peripheral to trigger.
+ * @return The event channel used, for unrouteTc5Event, or -1 if there are no free channels.
+ */
+int8_t ZeroTC45::routeTc5Event(TcEvent event, uint8_t user) {
+    int8_t channel = connectEvent(EVSYS_ID_GEN_TC5_OVF + event, user);
+    if (channel >= 0) {
+        updateEventOutputs(TC5, EVSYS_ID_GEN_TC5_OVF);
+    }
+    return channel;
+}
+
+/**
+ * Disconnect an event routed by routeTc4Event. The TC4 event output is
+ * turned off once no channel uses it.
+ *
+ * @param channel The channel returned by routeTc4Event.
+ */
+void ZeroTC45::unrouteTc4Event(int8_t channel) {
+    disconnectEvent(channel);
+    updateEventOutputs(TC4, EVSYS_ID_GEN_TC4_OVF);
+}
+
+/**
+ * Disconnect an event routed by routeTc5Event.
+ *
+ * @param channel The channel returned by routeTc5Event.
+ */
+void ZeroTC45::unrouteTc5Event(int8_t channel) {
+    disconnectEvent(channel);
+    updateEventOutputs(TC5, EVSYS_ID_GEN_TC5_OVF);
+}
+
+/**
+ * Connect an event generator to an event user through a free event system
+ * channel. Channels are given out from the highest down, as other libraries
+ * tend to use the lowest.
+ *
+ * The channel uses the asynchronous path, which needs no clock and works in
+ * standby, but the user must accept asynchronous events.
+ *
+ * @param generator The EVSYS_ID_GEN_ value of the event generator.
+ * @param user The EVSYS_ID_USER_ value of the event user.
+ * @return The channel used, or -1 if there are no free channels.
+ */
+int8_t ZeroTC45::connectEvent(uint8_t generator, uint8_t user) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    int8_t channel = EVSYS_CHANNELS - 1;
+    while (channel >= 0 && (usedEventChannels & (1 << channel))) {
+        channel--;
+    }
+
+    if (channel >= 0) {
+        usedEventChannels |= 1 << channel;
+        eventGenerators[channel] = generator;
+        eventUsers[channel] = user;
+    }
+
+    __set_PRIMASK(primask);
+
+    if (channel < 0) {
+        return -1;
+    }
+
+    PM->APBCMASK.reg |= PM_APBCMASK_EVSYS;
+
+    // The user multiplexer takes the channel number plus one, zero means no channel.
+    EVSYS->USER.reg = EVSYS_USER_USER(user) | EVSYS_USER_CHANNEL(channel + 1);
+
+    // This register has to be written in a single operation.
+    EVSYS->CHANNEL.reg = EVSYS_CHANNEL_CHANNEL(channel)
+                       | EVSYS_CHANNEL_EVGEN(generator)
+                       | EVSYS_CHANNEL_PATH_ASYNCHRONOUS
+                       | EVSYS_CHANNEL_EDGSEL_NO_EVT_OUTPUT;
+
+    return channel;
+}
+
+/**
+ * Disconnect an event system channel given out by connectEvent.
+ *
+ * @param channel The channel returned by connectEvent.
+ */
+void ZeroTC45::disconnectEvent(int8_t channel) {
+    if (channel < 0 || channel >= EVSYS_CHANNELS || ! (usedEventChannels & (1 << channel))) {
+        return;
+    }
+
+    EVSYS->USER.reg = EVSYS_USER_USER(eventUsers[channel]);     // Channel zero, no channel.
+    EVSYS->CHANNEL.reg = EVSYS_CHANNEL_CHANNEL(channel);        // No generator.
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    usedEventChannels &= ~(1 << channel);
+    __set_PRIMASK(primask);
+}
+
+/**
+ * Sleep until TC4 or TC5 next fires, ie until the next callback, queued
+ * event or tickless deadline. Other interrupts run as usual but don't end
+ * the sleep.
+ *
+ * The sleep mode is the deepest one the TC clock keeps running in. The 32kHz
+ * sources run in standby, so the CPU, the main clocks and SysTick are all
+ * stopped; millis() doesn't count while in standby and USB is disconnected.
+ * OSC8M and DFLL48M stop in standby, so the deepest mode for them is idle,
+ * with only the CPU and bus clocks stopped.
+ *
+ * Must be called with interrupts enabled, eg from loop().
+ *
+ * @return How long the CPU slept in milliseconds, measured with the TC that fired. 0 if neither TC will fire, eg they are stopped or have no callback.
+ */
+uint32_t ZeroTC45::sleepUntilNextTimer() {
+    boolean wakeTc4 = willFire(TC4, tc4Tickless, tc4Callback);
+    boolean wakeTc5 = ! TC5->COUNT16.STATUS.bit.SLAVE && willFire(TC5, tc5Tickless, tc5Callback);
+    if ( ! wakeTc4 && ! wakeTc5) {
+        return 0;
+    }
+
+    boolean standby = (clock.source == OSCULP32K || clock.source == XOSC32K);
+
+    __disable_irq();
+
+    // Where each TC is in its period, for working out how long the sleep was.
+    uint32_t tc4Fires = tc4Callback.count;
+    uint32_t tc5Fires = tc5Callback.count;
+    uint32_t tc4Start = 0;
+    uint32_t tc5Start = 0;
+    uint32_t tc4End = 0;
+    uint32_t tc5End = 0;
+    if (wakeTc4) {
+        tc4Start = tc4Tickless.active ? readTicks(TC4, tc4Tickless) : readCount(TC4, tc4Callback.wide);
+        tc4End = tc4Callback.wide ? tc4Top32 : tc4Top;
+    }
+    if (wakeTc5) {
+        tc5Start = tc5Tickless.active ? readTicks(TC5, tc5Tickless) : readCount(TC5, false);
+        tc5End = tc5Top;
+    }
+
+    if (standby) {
+        SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+
+        // A SysTick interrupt can be pending when entering standby, which wakes the CPU straight away.
+        SysTick->CTRL &= ~SysTick_CTRL_TICKINT_Msk;
+    } else {
+        SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+        PM->SLEEP.reg = PM_SLEEP_IDLE_APB;
+    }
+
+    while (tc4Callback.count == tc4Fires && tc5Callback.count == tc5Fires) {
+        // A pending interrupt wakes the CPU even with interrupts disabled, so
+        // none can be missed between the check and the WFI.
+        __DSB();
+        __WFI();
+
+        // Let the interrupt that woke the CPU run.
+        __enable_irq();
+        __disable_irq();
+    }
+
+    if (standby) {
+        SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+        SysTick->CTRL |= SysTick_CTRL_TICKINT_Msk;
+    }
+
+    // A periodic TC has overflowed once, so the sleep was the rest of the period and the count since.
+    uint32_t ticks;
+    ClockConfig config;
+    if (tc4Callback.count != tc4Fires) {
+        config = getClockConfig();
+        ticks = tc4Tickless.active ? readTicks(TC4, tc4Tickless) - tc4Start
+                                   : tc4End + 1 - tc4Start + readCount(TC4, tc4Callback.wide);
+    } else {
+        config = getTc5ClockConfig();
+        ticks = tc5Tickless.active ? readTicks(TC5, tc5Tickless) - tc5Start
+                                   : tc5End + 1 - tc5Start + readCount(TC5, false);
+    }
+
+    __enable_irq();
+
+    // Only 0 if begin hasn't been called, as begin rejects configurations without a tick rate.
+    uint32_t hz = tickHz(config);
+    return (hz == 0) ? 0 : (uint64_t)ticks * 1000 / hz;
+}
+
+/**
+ * Set up the external interrupt of a pin to make an event on each rising
+ * edge, for connectEvent or startTc4OnEvent. The pin is switched to the EIC
+ * but its interrupt is not enabled, so attachInterrupt can't be used on the
+ * same pin at the same time.
+ *
+ * The capture modes measure both edges of a pulse, so for startTc4Capture
+ * the event must follow the level of the pin instead.
+ *
+ * @param pin The pin, which must have an external interrupt.
+ * @param level If true the event is high while the pin is, for startTc4Capture, instead of a pulse on each rising edge.
+ * @return The EVSYS_ID_GEN_EIC_EXTINT_ value of the pin, or 0 if it has no external interrupt.
+ */
+uint8_t ZeroTC45::pinEvent(uint8_t pin, boolean level) {
+    int8_t extint = g_APinDescription[pin].ulExtInt;
+    if (extint < 0 || extint > 15) {
+        return 0;
+    }
+
+    pinPeripheral(pin, PIO_EXTINT);
+
+    // Edge detection needs the EIC clock. GCLK 0 is the one the core uses for the EIC.
+    GCLK->CLKCTRL.reg = GCLK_CLKCTRL_CLKEN | GCLK_CLKCTRL_GEN(0) | GCLK_CLKCTRL_ID(GCM_EIC);
+    while (GCLK->STATUS.bit.SYNCBUSY);
+
+    // Each CONFIG register has the sense of 8 lines, 4 bits each.
+    uint8_t shift = (extint % 8) * 4;
+    EIC->CONFIG[extint / 8].reg = (EIC->CONFIG[extint / 8].reg & ~(EIC_CONFIG_SENSE0_Msk << shift))
+                                | ((level ? EIC_CONFIG_SENSE0_HIGH : EIC_CONFIG_SENSE0_RISE) << shift);
+    EIC->EVCTRL.reg |= 1 << extint;
+
+    EIC->CTRL.bit.ENABLE = 1;
+    while (EIC->STATUS.bit.SYNCBUSY);
+
+    return EVSYS_ID_GEN_EIC_EXTINT_0 + extint;
+}
+
+/**
+ * Set the NVIC priority of the TC4 interrupt. The default is 0, the highest,
+ * which is above the USB, SERCOM and DMAC interrupts of the Arduino core, so
+ * a long callback can make them lose data. A lower priority lets them
+ * preempt the callback instead. The priority applies straight away, and to
+ * each start after this.
+ *
+ * @param priority 0 (highest) - 3 (lowest). The SAMD21 has two priority bits.
+ */
+void ZeroTC45::setTc4Priority(uint8_t priority) {
+    tc4Priority = (priority > 3) ? 3 : priority;
+    NVIC_SetPriority(TC4_IRQn, tc4Priority);
+}
+
+/**
+ * Set the NVIC priority of the TC5 interrupt. See setTc4Priority.
+ *
+ * @param priority 0 (highest) - 3 (lowest).
+ */
+void ZeroTC45::setTc5Priority(uint8_t priority) {
+    tc5Priority = (priority > 3) ? 3 : priority;
+    NVIC_SetPriority(TC5_IRQn, tc5Priority);
+}
+
+/**
+ * Turn the deferred callback of TC4 or TC5 on or off, for setTc4Deferred.
+ * Calls still waiting for the deferred interrupt when it is turned off are
+ * still made.
+ *
+ * @param tc The TC, must be TC4 or TC5.
+ * @param deferred If true call the callback from the deferred interrupt.
+ */
+void ZeroTC45::setDeferred(Tc* tc, boolean deferred) {
+    ((tc == TC4) ? tc4Callback : tc5Callback).deferred = deferred;
+}
+
+/**
+ * Drive a pin with a PWM waveform from TC4, with no interrupts. The TC4
+ * waveform outputs are WO0 on PA22, PB08 and PB12, and WO1 on PA23, PB09
+ * and PB13.
+ *
+ * With a period, TC4 uses match PWM mode, where CC0 sets the period, so
+ * only a WO1 pin can be driven. With no period, TC4 uses normal PWM mode
+ * and counts to 0xFFFF, and a second call with a pin on the other output
+ * drives it too, with its own duty cycle, without restarting the counter.
+ *
+ * The pin is high from the start of each period for duty ticks. The
+ * callback, if there is one, is called at the end of each period.
+ *
+ * @param pin The pin to drive.
+ * @param duty The high time in ticks of the TC4 resolution.
+ * @param period The period in ticks of the TC4 resolution, or 0 for 65536 ticks.
+ * @return true if the pin is driven, false if TC4 can't drive the pin in that mode.
+ */
+boolean ZeroTC45::startTc4Pwm(uint8_t pin, uint16_t duty, uint16_t period) {
+    return configurePwm(TC4, pin, duty, period);
+}
+
+/**
+ * Drive a pin with a PWM waveform from TC5. The TC5 waveform outputs are
+ * WO0 on PA24, PB10 and PB14, and WO1 on PA25, PB11 and PB15. See startTc4Pwm.
+ *
+ * @param pin The pin to drive.
+ * @param duty The high time in ticks of the TC5 resolution.
+ * @param period The period in ticks of the TC5 resolution, or 0 for 65536 ticks.
+ * @return true if the pin is driven, false if TC5 can't drive the pin in that mode.
+ */
+boolean ZeroTC45::startTc5Pwm(uint8_t pin, uint16_t duty, uint16_t period) {
+    return configurePwm(TC5, pin, duty, period);
+}
+
+/**
+ * Change the duty cycle of a pin driven by startTc4Pwm. This is a single
+ * write to the CC register, with no wait for it to synchronise, so it can
+ * be called from an interrupt.
+ *
+ * The SAMD21 TC has no buffered CC registers, so the new value is used
+ * straight away. If the duty is lowered below the count while the pin is
+ * high, the pin stays high until the end of that period.
+ *
+ * @param pin The pin given to startTc4Pwm.
+ * @param duty The high time in ticks of the TC4 resolution.
+ * @return true if the duty was changed, false if TC4 isn't driving the pin.
+ */
+boolean ZeroTC45::setTc4Duty(uint8_t pin, uint16_t duty) {
+    int8_t output = pwmOutput(TC4, pin);
+    if (output < 0 || tc4PwmPins[output] != pin) {
+        return false;
+    }
+
+    waitSync(TC4);
+    TC4->COUNT16.CC[output].reg = duty;
+    return true;
+}
+
+/**
+ * Change the duty cycle of a pin driven by startTc5Pwm. See setTc4Duty.
+ *
+ * @param pin The pin given to startTc5Pwm.
+ * @param duty The high time in ticks of the TC5 resolution.
+ * @return true if the duty was changed, false if TC5 isn't driving the pin.
+ */
+boolean ZeroTC45::setTc5Duty(uint8_t pin, uint16_t duty) {
+    int8_t output = pwmOutput(TC5, pin);
+    if (output < 0 || tc5PwmPins[output] != pin) {
+        return false;
+    }
+
+    waitSync(TC5);
+    TC5->COUNT16.CC[output].reg = duty;
+    return true;
+}
+
+/**
+ * Measure the pulses of an event, eg a pin given by pinEvent, with TC4 in
+ * capture mode. At the start of each pulse the count since the last start,
+ * the period, is latched into a CC register and the counter restarts from
+ * zero, and at the end of the pulse the count, the width, is latched into
+ * the other one. This is done by the hardware, so the values have no
+ * interrupt latency or jitter.
+ *
+ * The values are in ticks of the TC4 resolution, and a period must be less
+ * than 65536 ticks. If no pulse starts for a whole count, the values read
+ * become 0. The callback is called from the interrupt after each pulse, and
+ * readTc4Capture returns the last values.
+ *
+ * @param generator The EVSYS_ID_GEN_ value of the event to measure.
+ * @param mode CAPTURE_PPW to latch the period into CC0 and the width into CC1, CAPTURE_PWP for the other way round.
+ * @return true if TC4 is capturing, false if there are no free event channels.
+ */
+boolean ZeroTC45::startTc4Capture(uint8_t generator, CaptureMode mode) {
+    return configureCapture(TC4, generator, mode);
+}
+
+/**
+ * Measure the pulses of an event with TC5 in capture mode. See startTc4Capture.
+ *
+ * @param generator The EVSYS_ID_GEN_ value of the event to measure.
+ * @param mode CAPTURE_PPW to latch the period into CC0 and the width into CC1, CAPTURE_PWP for the other way round.
+ * @return true if TC5 is capturing, false if there are no free event channels.
+ */
+boolean ZeroTC45::startTc5Capture(uint8_t generator, CaptureMode mode) {
+    return configureCapture(TC5, generator, mode);
+}
+
+/**
+ * Read the last pulse measured by TC4 in capture mode.
+ *
+ * @param period Set to the ticks from the start of the pulse to the start of the next, or 0 if the pulses stopped.
+ * @param width Set to the ticks from the start of the pulse to its end, or 0 if the pulses stopped.
+ * @return true if this is a new measurement since the last call, false if it was returned before.
+ */
+boolean ZeroTC45::readTc4Capture(uint16_t& period, uint16_t& width) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    period = tc4Capture.period;
+    width = tc4Capture.width;
+    boolean fresh = tc4Capture.fresh;
+    tc4Capture.fresh = false;
+    __set_PRIMASK(primask);
+    return fresh;
+}
+
+/**
+ * Read the last pulse measured by TC5 in capture mode. See readTc4Capture.
+ *
+ * @param period Set to the ticks from the start of the pulse to the start of the next, or 0 if the pulses stopped.
+ * @param width Set to the ticks from the start of the pulse to its end, or 0 if the pulses stopped.
+ * @return true if this is a new measurement since the last call, false if it was returned before.
+ */
+boolean ZeroTC45::readTc5Capture(uint16_t& period, uint16_t& width) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    period = tc5Capture.period;
+    width = tc5Capture.width;
+    boolean fresh = tc5Capture.fresh;
+    tc5Capture.fresh = false;
+    __set_PRIMASK(primask);
+    return fresh;
+}
+
+/**
+ * Set up TC4 with the period and one-shot setting of startTc4, but hold it
+ * stopped with the count at zero until the event from generator arrives. The
+ * TC START event action then starts the counter in hardware, so timers on
+ * several boards given the same edge, eg with pinEvent, start together
+ * rather than when each one's register writes have synchronised.
+ *
+ * The counter starts on the first TC clock after the event, so boards agree
+ * to within one tick of the resolution. Later events are ignored while the
+ * counter runs. stopTc4 or startTc4 disconnect the event.
+ *
+ * @param period The amount of time in seconds between calls to the callback function.
+ * @param generator The EVSYS_ID_GEN_ value of the event that starts the counter.
+ * @param oneShot If true the callback will only be called once.
+ * @return true if TC4 is waiting for the event, false if there are no free event channels.
+ */
+boolean ZeroTC45::startTc4OnEvent(uint16_t period, uint8_t generator, boolean oneShot) {
+    return configureOnEvent(TC4, period, generator, oneShot);
+}
+
+/**
+ * Set up TC5 and hold it stopped until the event from generator starts
+ * it. See startTc4OnEvent.
+ *
+ * @param period The amount of time in seconds between calls to the callback function.
+ * @param generator The EVSYS_ID_GEN_ value of the event that starts the counter.
+ * @param oneShot If true the callback will only be called once.
+ * @return true if TC5 is waiting for the event, false if there are no free event channels.
+ */
+boolean ZeroTC45::startTc5OnEvent(uint16_t period, uint8_t generator, boolean oneShot) {
+    return configureOnEvent(TC5, period, generator, oneShot);
+}
+
+/**
+ * Stop a TC by giving it a stop command, disabling the TC overflow interrupt, and
+ * clearing and disabling the TC-specific interrupt line.
+ *
+ * The interrupts are disabled straight away because the interrupt registers
+ * are not synchronised, so no callback can happen after this returns even if
+ * the stop command is still being synchronised.
+ *
+ * @param tc The TC to configure, must be TC4 or TC5.
+ * @param wait If true wait until the stop command has reached the TC before returning.
+ */
+void stopTC(Tc* tc, boolean wait) {
+    ZeroTC45TimerRegisters::disableInterrupts(tc);
+    releaseInputEvent(tc);
+    releasePwm(tc);
+    ((tc == TC4) ? tc4Callback : tc5Callback).burstRemaining = 0;
+    ZeroTC45TimerRegisters::stop(tc);
+    TRACE_EVENT(STOP, tc);
+
+    if (tc == TC4) {
+        NVIC_ClearPendingIRQ(TC4_IRQn);
+        NVIC_DisableIRQ (TC4_IRQn);
+        tc4Tickless.active = false;
+        tc4Tickless.armed = false;
+    } else if (tc == TC5) {
+        NVIC_ClearPendingIRQ(TC5_IRQn);
+        NVIC_DisableIRQ (TC5_IRQn);
+        tc5Tickless.active = false;
+        tc5Tickless.armed = false;
+    }
+
+    if (wait) {
+        waitSync(tc);
+    }
+}
+
+/**
+ * Configure the given TC (must be TC4 or TC5) to count in seconds and
+ * cause a match interrupt at matchValue seconds.
+ *
+ * The registers are written by ZeroTC45TimerRegisters::configure, which
+ * TC3 uses as well. It only writes the registers whose values change, and
+ * if the TC is already enabled with the same CTRLA configuration (eg it was
+ * stopped by stopTc4, or is a finished one-shot) it isn't disabled at all
+ * and the counter is restarted with a retrigger command. Restarting a
+ * one-shot with the same period then costs a single synchronised write.
+ *
+ * Without wait the last write, the one that starts the TC, is not waited
+ * for, but the ones before it are. With hold the TC is left stopped, or
+ * disabled, with everything else set up, for startHeld to start it.
+ *
+ * @param tc The TC to configure, must be TC4 or TC5.
+ * @param period The amount of time in seconds between overflow interrupts.
+ * @param oneShot If true then the TC one-shot mode is enabled.
+ * @param wait If true wait until the TC has started, or with hold is ready to start, before returning.
+ * @param hold If true don't start the TC.
+ */
+void ZeroTC45::configureTC(Tc* tc, uint16_t period, boolean oneShot, boolean wait, boolean hold) {
+
+    TicklessState& state = (tc == TC4) ? tc4Tickless : tc5Tickless;
+    state.active = false;
+    state.armed = false;
+
+    releaseInputEvent(tc);
+    releasePwm(tc);
+
+    uint16_t& top = (tc == TC4) ? tc4Top : tc5Top;
+    TimerCallback& callback = (tc == TC4) ? tc4Callback : tc5Callback;
+    callback.burstRemaining = 0;
+
+    // A one-shot only fires once so has no period to check.
+    setTiming(callback, oneShot ? 0 : period, timingHz(tc));
+
+    callback.wide = false;
+    uint16_t ticks = scalePeriod(callback, period, oneShot, 0xFFFF);
+
+    // The interrupt is generated on the count after the overflow so wait 1 tick less than the caller specifies.
+    // The register writes are shared with the other timers, and also keep the count continuously
+    // synchronised, so elapsedTc4 and remainingTc4 don't wait for a read request.
+    ZeroTC45TimerRegisters::configure(tc, prescaler(tc), ticks - 1, oneShot, hasCallback(callback), &top, hold, wait);
+
+    if ( ! hold) {
+        TRACE_EVENT(START, tc);
+    }
+
+    // Enable the TC interrupt vector
+    // Set the priority given to setTc4Priority/setTc5Priority
+    if (tc == TC4) {
+        NVIC_ClearPendingIRQ(TC4_IRQn);
+        NVIC_EnableIRQ (TC4_IRQn);
+        NVIC_SetPriority(TC4_IRQn, tc4Priority);
+    } else if (tc == TC5) {
+        NVIC_ClearPendingIRQ(TC5_IRQn);
+        NVIC_EnableIRQ (TC5_IRQn);
+        NVIC_SetPriority(TC5_IRQn, tc5Priority);
+    }
+}
+
+/**
+ * Wait until no write to a TC is being synchronised. Polling SYNCBUSY lets
+ * interrupts run while waiting, where the next synchronised write would
+ * stall the bus instead. STATUS can be read without synchronisation.
+ *
+ * @param tc The TC, must be TC4 or TC5.
+ */
+static inline void waitSync(Tc* tc) {
+    while (tc->COUNT16.STATUS.bit.SYNCBUSY);
+}
+
+/**
+ * Start a TC left by configureTC with hold, with a single synchronised
+ * write: an enable if it was configured from disabled, otherwise a
+ * retrigger. CTRLA can be read without synchronisation.
+ *
+ * @param tc The TC to start, must be TC4 or TC5.
+ */
+static inline void startHeld(Tc* tc) {
+    uint16_t ctrla = tc->COUNT16.CTRLA.reg;
+    waitSync(tc);
+    if (ctrla & TC_CTRLA_ENABLE) {
+        tc->COUNT16.CTRLBSET.reg = TC_CTRLBSET_CMD_RETRIGGER;
+    } else {
+        tc->COUNT16.CTRLA.reg = ctrla | TC_CTRLA_ENABLE;
+    }
+}
+
+/**
+ * Configure a TC like configureTC for a burst of fires. The TC is held while
+ * the count is set, so even the first fire of a short period is counted.
+ *
+ * @param tc The TC to configure, must be TC4 or TC5.
+ * @param period The time between fires.
+ * @param count The number of fires.
+ */
+void ZeroTC45::configureBurst(Tc* tc, uint16_t period, uint16_t count) {
+    if (count == 0) {
+        stopTC(tc, true);
+        return;
+    }
+
+    // A burst of one is a one-shot from the start.
+    configureTC(tc, period, count == 1, true, true);
+    ((tc == TC4) ? tc4Callback : tc5Callback).burstRemaining = (count == 1) ? 0 : count;
+
+    startHeld(tc);
+    TRACE_EVENT(START, tc);
+    while (tc->COUNT16.STATUS.bit.SYNCBUSY);
+}
+
+/**
+ * Configure a TC like configureTC without starting it, and connect the event
+ * from generator to its START event action.
+ *
+ * The TC is disabled first so configureTC leaves it disabled with hold, and
+ * EVCTRL is set while it is disabled. With the START event action enabling
+ * the TC doesn't start the counter, so it never counts, or fires, before
+ * the event.
+ *
+ * @param tc The TC to configure, must be TC4 or TC5.
+ * @param period The amount of time in seconds between overflow interrupts.
+ * @param generator The EVSYS_ID_GEN_ value of the event that starts the counter.
+ * @param oneShot If true then the TC one-shot mode is enabled.
+ * @return true if the TC is waiting for the event, false if there are no free event channels.
+ */
+boolean ZeroTC45::configureOnEvent(Tc* tc, uint16_t period, uint8_t generator, boolean oneShot) {
+    uint16_t ctrla = tc->COUNT16.CTRLA.reg;
+    if (ctrla & TC_CTRLA_ENABLE) {
+        waitSync(tc);
+        tc->COUNT16.CTRLA.reg = ctrla & ~TC_CTRLA_ENABLE;
+    }
+
+    configureTC(tc, period, oneShot, true, true);
+
+    int8_t channel = connectEvent(generator, (tc == TC4) ? EVSYS_ID_USER_TC4_EVU : EVSYS_ID_USER_TC5_EVU);
+    if (channel < 0) {
+        stopTC(tc, true);
+        return false;
+    }
+
+    if (tc == TC4) {
+        tc4InputChannel = channel;
+    } else {
+        tc5InputChannel = channel;
+    }
+
+    // EVCTRL is not synchronised.
+    tc->COUNT16.EVCTRL.reg = (tc->COUNT16.EVCTRL.reg & ~TC_EVCTRL_EVACT_Msk) | TC_EVCTRL_TCEI | TC_EVCTRL_EVACT_START;
+
+    // The count is kept while disabled, so start the first period from zero.
+    waitSync(tc);
+    tc->COUNT16.COUNT.reg = 0;
+
+    waitSync(tc);
+    tc->COUNT16.CTRLA.reg |= TC_CTRLA_ENABLE;
+    waitSync(tc);
+    return true;
+}
+
+/**
+ * Stop a TC and set the prescaler and period scale for a resolution, if it
+ * can be made from the GCLK already set up.
+ *
+ * @param tc The TC to change, must be TC4 or TC5.
+ * @param resolution The new resolution.
+ * @return true if the resolution was changed.
+ */
+boolean ZeroTC45::changePrescaler(Tc* tc, Resolution resolution) {
+    if ( ! changePrescaler(tc, resolutionConfig(resolution))) {
+        return false;
+    }
+
+    // The oscillator is the same so it is still out by the same amount.
+    TimerCallback& callback = (tc == TC4) ? tc4Callback : tc5Callback;
+    int32_t ppb = callback.correctionPpb;
+
+    if (resolution == CRYSTAL_MILLISECONDS) {
+        setScale(callback, 1024, 1000);
+    } else {
+        setScale(callback, 0, 0);
+    }
+    setCorrection(callback, ppb);
+
+    return true;
+}
+
+/**
+ * Stop a TC and set its prescaler, if the configuration can be made from
+ * the GCLK already set up. The period scale and correction are left alone.
+ *
+ * @param tc The TC to change, must be TC4 or TC5.
+ * @param config The clock configuration with the new prescaler.
+ * @return true if the prescaler was changed.
+ */
+boolean ZeroTC45::changePrescaler(Tc* tc, ClockConfig config) {
+    boolean sameClock = config.source == clock.source
+                     || (sourceHz(config.source) == 32768 && sourceHz(clock.source) == 32768);
+    if ( ! sameClock || config.gclkDivisor != clock.gclkDivisor) {
+        return false;
+    }
+
+    stopTC(tc, true);
+
+    if (tc == TC4) {
+        clock.prescaler = config.prescaler;
+    } else {
+        tc5Prescaler = config.prescaler;
+    }
+
+    return true;
+}
+
+/**
+ * Set up the state of TC4 or TC5 for a ZeroTC, which writes the TC registers
+ * itself with its compile time prescaler. The TC is stopped and given the
+ * prescaler, the period is kept as whole ticks with no calibration
+ * correction, and the interrupt vector is enabled, so the interrupt handler,
+ * statistics and elapsedTc4 work as they would after startTc4.
+ *
+ * @param tc The TC, must be TC4 or TC5.
+ * @param config The clock configuration of the ZeroTC resolution.
+ * @param period The period in ticks.
+ * @param oneShot If true the TC will stop at the first overflow.
+ * @param interrupt Set to whether the overflow interrupt is needed.
+ * @return false if the configuration needs a different GCLK to the one given to begin.
+ */
+boolean ZeroTC45::prepareTC(Tc* tc, ClockConfig config, uint16_t period, boolean oneShot, boolean& interrupt) {
+    if ( ! changePrescaler(tc, config)) {
+        return false;
+    }
+
+    TimerCallback& callback = (tc == TC4) ? tc4Callback : tc5Callback;
+    setScale(callback, 0, 0);
+    setTiming(callback, oneShot ? 0 : period, timingHz(tc));
+    callback.wide = false;
+    ((tc == TC4) ? tc4Top : tc5Top) = scalePeriod(callback, period, oneShot, 0xFFFF) - 1;
+    interrupt = hasCallback(callback);
+
+    IRQn_Type irqn = (tc == TC4) ? TC4_IRQn : TC5_IRQn;
+    NVIC_ClearPendingIRQ(irqn);
+    NVIC_SetPriority(irqn, (tc == TC4) ? tc4Priority : tc5Priority);
+    NVIC_EnableIRQ(irqn);
+    return true;
+}
+
+/**
+ * Configure a TC in normal or match PWM mode and switch a pin to its
+ * waveform output. If the TC is already running in the same mode, eg to add
+ * the second output in normal PWM mode, only the CC registers are written.
+ *
+ * @param tc The TC to configure, must be TC4 or TC5.
+ * @param pin The pin to drive.
+ * @param duty The high time in ticks.
+ * @param period The period in ticks, or 0 for normal PWM mode.
+ * @return true if the pin is driven, false if the TC can't drive the pin in that mode.
+ */
+boolean ZeroTC45::configurePwm(Tc* tc, uint8_t pin, uint16_t duty, uint16_t period) {
+    int8_t output = pwmOutput(tc, pin);
+
+    // In match PWM mode CC0 is TOP, so WO0 has no duty cycle of its own.
+    if (output < 0 || (period != 0 && output != 1)) {
+        return false;
+    }
+
+    int8_t* pins = (tc == TC4) ? tc4PwmPins : tc5PwmPins;
+    uint16_t& top = (tc == TC4) ? tc4Top : tc5Top;
+    TimerCallback& callback = (tc == TC4) ? tc4Callback : tc5Callback;
+
+    uint16_t ctrla = TC_CTRLA_MODE_COUNT16
+                   | ((period != 0) ? TC_CTRLA_WAVEGEN_MPWM : TC_CTRLA_WAVEGEN_NPWM)
+                   | TC_CTRLA_RUNSTDBY;           // Run when in standby mode.
+
+    ctrla |= TC_CTRLA_PRESCALER(prescaler(tc));   // Divide the input GCLK frequency by the prescaler for the tick rate.
+
+    uint16_t current = tc->COUNT16.CTRLA.reg;
+    boolean running = (pins[0] >= 0 || pins[1] >= 0) && (current & ~TC_CTRLA_ENABLE) == ctrla;
+
+    if ( ! running) {
+        stopTC(tc, true);
+
+        // The waveform period isn't checked or corrected, and isn't scaled.
+        setTiming(callback, 0, 0);
+        callback.period = 0;
+        callback.corrected = false;
+        callback.wide = false;
+
+        // Disable TC so it can be configured. Each synchronised write waits for the one before, see ZeroTC45TimerRegisters::configure.
+        waitSync(tc);
+        tc->COUNT16.CTRLA.reg = current & ~TC_CTRLA_ENABLE;
+        while (tc->COUNT16.STATUS.bit.SYNCBUSY);
+
+        waitSync(tc);
+        tc->COUNT16.CTRLA.reg = ctrla;
+        waitSync(tc);
+        tc->COUNT16.CTRLBCLR.reg = TC_CTRLBCLR_ONESHOT | TC_CTRLBCLR_DIR;
+        waitSync(tc);
+        tc->COUNT16.COUNT.reg = 0;
+        waitSync(tc);
+        tc->COUNT16.CC[0].reg = 0;
+        waitSync(tc);
+        tc->COUNT16.CC[1].reg = 0;
+    }
+
+    // In normal PWM mode the TC counts to 0xFFFF, which is remembered as the top for remainingTc4.
+    top = (period != 0) ? period - 1 : 0xFFFF;
+    if (period != 0) {
+        waitSync(tc);
+        tc->COUNT16.CC[0].reg = top;
+    }
+    waitSync(tc);
+    tc->COUNT16.CC[output].reg = duty;
+
+    pins[output] = pin;
+    pinPeripheral(pin, PIO_TIMER);
+
+    if ( ! running) {
+        // Only interrupt at the end of each period if there is a callback. The interrupt registers are not synchronised.
+        tc->COUNT16.INTFLAG.reg = TC_INTFLAG_OVF;
+        if (hasCallback(callback)) {
+            tc->COUNT16.INTENSET.reg = TC_INTENSET_OVF;
+        }
+
+        readContinuously(tc);
+
+        waitSync(tc);
+        tc->COUNT16.CTRLA.reg = ctrla | TC_CTRLA_ENABLE;
+        TRACE_EVENT(START, tc);
+        while (tc->COUNT16.STATUS.bit.SYNCBUSY);
+
+        IRQn_Type irqn = (tc == TC4) ? TC4_IRQn : TC5_IRQn;
+        NVIC_ClearPendingIRQ(irqn);
+        NVIC_EnableIRQ(irqn);
+        NVIC_SetPriority(irqn, (tc == TC4) ? tc4Priority : tc5Priority);
+    }
+
+    return true;
+}
+
+/**
+ * Configure a TC in 16-bit normal frequency mode with both compare channels
+ * capturing, and connect the event from generator to its PPW or PWP event
+ * action.
+ *
+ * @param tc The TC to configure, must be TC4 or TC5.
+ * @param generator The EVSYS_ID_GEN_ value of the event to measure.
+ * @param mode Which CC register the period is captured into.
+ * @return true if the TC is capturing, false if there are no free event channels.
+ */
+boolean ZeroTC45::configureCapture(Tc* tc, uint8_t generator, CaptureMode mode) {
+    stopTC(tc, true);
+
+    TicklessState& state = (tc == TC4) ? tc4Tickless : tc5Tickless;
+    CaptureState& capture = (tc == TC4) ? tc4Capture : tc5Capture;
+    TimerCallback& callback = (tc == TC4) ? tc4Callback : tc5Callback;
+
+    state.active = false;
+    state.armed = false;
+
+    // Pulses aren't periodic and their values aren't scaled.
+    setTiming(callback, 0, 0);
+    callback.period = 0;
+    callback.corrected = false;
+    callback.wide = false;
+
+    int8_t channel = connectEvent(generator, (tc == TC4) ? EVSYS_ID_USER_TC4_EVU : EVSYS_ID_USER_TC5_EVU);
+    if (channel < 0) {
+        return false;
+    }
+
+    if (tc == TC4) {
+        tc4InputChannel = channel;
+    } else {
+        tc5InputChannel = channel;
+    }
+
+    // Disable TC so it can be configured. Each synchronised write waits for the one before, see ZeroTC45TimerRegisters::configure.
+    waitSync(tc);
+    tc->COUNT16.CTRLA.reg &= ~TC_CTRLA_ENABLE;
+    while (tc->COUNT16.STATUS.bit.SYNCBUSY);
+
+    uint16_t ctrla = TC_CTRLA_MODE_COUNT16        // Use 16-bit counting mode.
+                   | TC_CTRLA_WAVEGEN_NFRQ        // Count to 0xFFFF, the counter is restarted by each pulse.
+                   | TC_CTRLA_RUNSTDBY;           // Run when in standby mode.
+
+    ctrla |= TC_CTRLA_PRESCALER(prescaler(tc));   // Divide the input GCLK frequency by the prescaler for the tick rate.
+
+    waitSync(tc);
+    tc->COUNT16.CTRLA.reg = ctrla;
+    waitSync(tc);
+    tc->COUNT16.CTRLC.reg = TC_CTRLC_CPTEN0 | TC_CTRLC_CPTEN1;
+    waitSync(tc);
+    tc->COUNT16.CTRLBCLR.reg = TC_CTRLBCLR_ONESHOT;
+    waitSync(tc);
+    tc->COUNT16.COUNT.reg = 0;
+
+    uint16_t evact = (mode == CAPTURE_PPW) ? TC_EVCTRL_EVACT_PPW : TC_EVCTRL_EVACT_PWP;
+    tc->COUNT16.EVCTRL.reg = (tc->COUNT16.EVCTRL.reg & ~TC_EVCTRL_EVACT_Msk) | TC_EVCTRL_TCEI | evact;
+
+    // The end of a pulse is captured by the channel the period isn't captured by.
+    capture.lastFlag = (mode == CAPTURE_PPW) ? TC_INTFLAG_MC1 : TC_INTFLAG_MC0;
+    capture.period = 0;
+    capture.width = 0;
+    capture.fresh = false;
+    capture.active = true;
+
+    // The interrupt registers are not synchronised.
+    tc->COUNT16.INTFLAG.reg = TC_INTFLAG_OVF | TC_INTFLAG_MC0 | TC_INTFLAG_MC1;
+    tc->COUNT16.INTENSET.reg = TC_INTENSET_OVF | ((mode == CAPTURE_PPW) ? TC_INTENSET_MC1 : TC_INTENSET_MC0);
+
+    waitSync(tc);
+    tc->COUNT16.CTRLA.reg = ctrla | TC_CTRLA_ENABLE;
+    TRACE_EVENT(START, tc);
+    while (tc->COUNT16.STATUS.bit.SYNCBUSY);
+
+    IRQn_Type irqn = (tc == TC4) ? TC4_IRQn : TC5_IRQn;
+    NVIC_ClearPendingIRQ(irqn);
+    NVIC_EnableIRQ(irqn);
+    NVIC_SetPriority(irqn, (tc == TC4) ? tc4Priority : tc5Priority);
+
+    return true;
+}
+
+/**
+ * Configure TC4 and TC5 as one 32-bit counter and cause an overflow
+ * interrupt from TC4 every period ticks.
+ *
+ * @param period The amount of time in ticks between overflow interrupts.
+ * @param oneShot If true then the TC one-shot mode is enabled.
+ */
+void ZeroTC45::configureTC32(uint32_t period, boolean oneShot) {
+
+    tc4Tickless.active = false;
+    tc4Tickless.armed = false;
+
+    // TC5 becomes the slave, so stop it being used on its own.
+    stopTC(TC5, false);
+    releaseInputEvent(TC4);
+    releasePwm(TC4);
+
+    setTiming(tc4Callback, oneShot ? 0 : period, timingHz(TC4));
+
+    tc4Callback.burstRemaining = 0;
+    tc4Callback.wide = true;
+    period = scalePeriod(tc4Callback, period, oneShot, 0xFFFFFFFF);
+
+    // Both TCs must be disabled before TC4 can be put into 32-bit mode.
+    // Each synchronised write waits for the one before, see ZeroTC45TimerRegisters::configure.
+    waitSync(TC5);
+    TC5->COUNT16.CTRLA.reg &= ~TC_CTRLA_ENABLE;
+    while (TC5->COUNT16.STATUS.bit.SYNCBUSY);
+
+    Tc* tc = TC4;
+
+    waitSync(tc);
+    tc->COUNT32.CTRLA.reg &= ~TC_CTRLA_ENABLE;
+    while (tc->COUNT32.STATUS.bit.SYNCBUSY);
+
+    uint16_t ctrla = TC_CTRLA_MODE_COUNT32        // Use 32-bit counting mode, with TC5 as the slave.
+                   | TC_CTRLA_WAVEGEN(1)          // Use MFRQ mode so CC0 is 'TOP' and we get an overflow every time CC0 is reached.
+                   | TC_CTRLA_RUNSTDBY;           // Run when in standby mode.
+
+    ctrla |= TC_CTRLA_PRESCALER(clock.prescaler); // Divide the input GCLK frequency by the prescaler for the tick rate.
+
+    waitSync(tc);
+    tc->COUNT32.CTRLA.reg = ctrla;
+
+    // Enable overflow interrupts only, and only if there is a callback.
+    tc->COUNT32.INTENCLR.reg = TC_INTENCLR_MC0 | TC_INTENCLR_MC1;
+    tc->COUNT32.INTFLAG.reg = TC_INTFLAG_OVF;
+    if (hasCallback(tc4Callback)) {
+        tc->COUNT32.INTENSET.reg = TC_INTENSET_OVF;
+    } else {
+        tc->COUNT32.INTENCLR.reg = TC_INTENCLR_OVF;
+    }
+
+    if (oneShot) {
+        waitSync(tc);
+        tc->COUNT32.CTRLBSET.reg = TC_CTRLBSET_ONESHOT;
+    } else {
+        waitSync(tc);
+        tc->COUNT32.CTRLBCLR.reg = TC_CTRLBCLR_ONESHOT;
+    }
+
+    waitSync(tc);
+    tc->COUNT32.COUNT.reg = 0;
+
+    // The interrupt is generated on the count after the overflow so wait 1 tick less than the caller specifies.
+    tc4Top32 = period - 1;
+    waitSync(tc);
+    tc->COUNT32.CC[0].reg = tc4Top32;
+
+    readContinuously(tc);
+
+    // Enable the TC.
+    waitSync(tc);
+    tc->COUNT32.CTRLA.reg = ctrla | TC_CTRLA_ENABLE;
+    TRACE_EVENT(START, tc);
+    while (tc->COUNT32.STATUS.bit.SYNCBUSY);
+
+    // The master TC4 generates the interrupts.
+    NVIC_ClearPendingIRQ(TC4_IRQn);
+    NVIC_EnableIRQ (TC4_IRQn);
+    NVIC_SetPriority(TC4_IRQn, tc4Priority);
+}
+
+/**
+ * Configure the given TC (must be TC4 or TC5) to count freely through its
+ * 16-bit range for tickless mode. The overflow and CC1 at the half-way
+ * point interrupt to extend the count, and CC0 is used for the deadline.
+ *
+ * @param tc The TC to configure, must be TC4 or TC5.
+ */
+void ZeroTC45::configureTickless(Tc* tc) {
+
+    TicklessState& state = (tc == TC4) ? tc4Tickless : tc5Tickless;
+
+    // Disable the TC interrupt so the state isn't seen half-initialised.
+    IRQn_Type irqn = (tc == TC4) ? TC4_IRQn : TC5_IRQn;
+    NVIC_DisableIRQ(irqn);
+
+    releaseInputEvent(tc);
+    releasePwm(tc);
+
+    state.armed = false;
+    state.halfEpochs = 0;
+    state.halfEpochWraps = 0;
+    state.compareValid = false;
+
+    // Deadlines aren't periodic, lateness is checked when each is reached.
+    TimerCallback& callback = (tc == TC4) ? tc4Callback : tc5Callback;
+    setTiming(callback, 0, 0);
+    callback.period = 0;
+    callback.corrected = false;
+    state.leadTicks = COMPARE_SYNC_CLOCKS / prescalerDivision(prescaler(tc)) + 1;
+
+    // Disable TC so it can be configured. Each synchronised write waits for the one before, see ZeroTC45TimerRegisters::configure.
+    waitSync(tc);
+    tc->COUNT16.CTRLA.reg &= ~TC_CTRLA_ENABLE;
+    while (tc->COUNT16.STATUS.bit.SYNCBUSY);
+
+    uint16_t ctrla = TC_CTRLA_MODE_COUNT16        // Use 16-bit counting mode.
+                   | TC_CTRLA_WAVEGEN_NFRQ        // Count to 0xFFFF and wrap so the count is a free running clock.
+                   | TC_CTRLA_RUNSTDBY;           // Run when in standby mode.
+
+    ctrla |= TC_CTRLA_PRESCALER(prescaler(tc));   // Divide the input GCLK frequency by the prescaler for the tick rate.
+
+    waitSync(tc);
+    tc->COUNT16.CTRLA.reg = ctrla;
+
+    // The CC0 interrupt is enabled by armCompare() when there is a deadline.
+    tc->COUNT16.INTENCLR.reg = TC_INTENCLR_MC0;
+    tc->COUNT16.INTFLAG.reg = TC_INTFLAG_OVF | TC_INTFLAG_MC0 | TC_INTFLAG_MC1;
+    tc->COUNT16.INTENSET.reg = TC_INTENSET_OVF | TC_INTENSET_MC1;
+
+    // A previous start may have left the TC in one-shot mode.
+    if (tc->COUNT16.CTRLBSET.bit.ONESHOT) {
+        waitSync(tc);
+        tc->COUNT16.CTRLBCLR.reg = TC_CTRLBCLR_ONESHOT;
+    }
+
+    waitSync(tc);
+    tc->COUNT16.COUNT.reg = 0;
+
+    // CC1 marks the half-way point of the count, see readTicks().
+    waitSync(tc);
+    tc->COUNT16.CC[1].reg = 0x8000;
+
+    // Keep COUNT continuously synchronised so it can be read without waiting.
+    waitSync(tc);
+    tc->COUNT16.READREQ.reg = TC_READREQ_RCONT | TC_READREQ_ADDR(TC_COUNT16_COUNT_OFFSET);
+
+    // Enable the TC, and wait so the count is valid before it is used.
+    waitSync(tc);
+    tc->COUNT16.CTRLA.reg = ctrla | TC_CTRLA_ENABLE;
+    TRACE_EVENT(START, tc);
+    while (tc->COUNT16.STATUS.bit.SYNCBUSY);
+
+    state.active = true;
+
+    // Enable the TC interrupt vector
+    // Set the priority given to setTc4Priority/setTc5Priority
+    NVIC_ClearPendingIRQ(irqn);
+    NVIC_EnableIRQ (irqn);
+    NVIC_SetPriority(irqn, (tc == TC4) ? tc4Priority : tc5Priority);
+}
+
+/**
+ * Returns the 32-bit tickless count, built from halfEpochs and the 16-bit count.
+ *
+ * The continuously synchronised count lags the real count by a few clocks,
+ * and an overflow or half-way interrupt may be pending, so the top bit of the
+ * count may not agree with the low bit of halfEpochs. When they disagree the
+ * size of the count shows which case it is: a count just below 0x10000 or 0x8000
+ * is stale, a count just above 0 or 0x8000 has an interrupt pending.
+ *
+ * Must be called with interrupts disabled.
+ *
+ * @param tc The TC to read, must be TC4 or TC5.
+ * @param state The tickless state of the TC.
+ */
+uint32_t readTicks(Tc* tc, TicklessState& state) {
+    uint32_t half = state.halfEpochs;
+    uint16_t count = tc->COUNT16.COUNT.reg;
+    uint32_t high = (half >> 1) + epochAdjustment(half, count);
+
+    return (high << 16) | count;
+}
+
+/**
+ * Returns the 64-bit tickless count, built from halfEpochWraps, halfEpochs
+ * and the 16-bit count, without disabling interrupts.
+ *
+ * The interrupt handler may run part way through. If it runs between the
+ * read of halfEpochs and the count, halfEpochs is stale in the same way as
+ * when the interrupt is pending, which epochAdjustment allows for. If it
+ * wraps halfEpochs during the reads, halfEpochWraps changes and the reads
+ * are made again.
+ *
+ * @param tc The TC to read, must be TC4 or TC5.
+ * @param state The tickless state of the TC.
+ */
+uint64_t readTicks64(Tc* tc, TicklessState& state) {
+    uint32_t wraps;
+    uint32_t half;
+    uint16_t count;
+
+    do {
+        wraps = state.halfEpochWraps;
+        half = state.halfEpochs;
+        count = tc->COUNT16.COUNT.reg;
+    } while (wraps != state.halfEpochWraps);
+
+    uint64_t high = (((uint64_t)wraps << 31) | (half >> 1)) + epochAdjustment(half, count);
+
+    return (high << 16) | count;
+}
+
+/**
+ * Work out whether the count is from the same pass of the 16-bit count as
+ * halfEpochs. See readTicks.
+ *
+ * @param half The value of halfEpochs read before the count.
+ * @param count The continuously synchronised count.
+ * @return What to add to the number of passes in halfEpochs: -1, 0 or 1.
+ */
+int8_t epochAdjustment(uint32_t half, uint16_t count) {
+    if ((half & 1) == (uint32_t)(count >> 15)) {
+        return 0;
     }
 
-    // Set the compare channel 0 value. In MFRQ mode this is used as 'TOP' to see when overflow occurs.
-    // The interrupt is generated on the count after the overflow so wait 1 second less than the caller specifies.
-    tc->COUNT16.CC[0].reg = period - 1;
-    while (tc->COUNT16.STATUS.bit.SYNCBUSY);
+    if (half & 1) {
+        // Last seen the half-way point, the count has wrapped but the overflow is pending.
+        return (count < 0x4000) ? 1 : 0;
+    }
 
-    // Enable overflow interrupts.
-    tc->COUNT16.INTENSET.bit.OVF = 1;
-    while (tc->COUNT16.STATUS.bit.SYNCBUSY);
+    // Last seen the overflow, the count is from before the wrap.
+    return (count >= 0xC000) ? -1 : 0;
+}
 
-    // Enable the TC.
-    tc->COUNT16.CTRLA.reg |= TC_CTRLA_ENABLE;
-    while (tc->COUNT16.STATUS.bit.SYNCBUSY);
+/**
+ * Set the tickless deadline of a TC and program its compare register.
+ *
+ * @param tc The TC, must be TC4 or TC5.
+ * @param state The tickless state of the TC.
+ * @param deadline The tick count to call the callback at.
+ */
+void setDeadline(Tc* tc, TicklessState& state, uint32_t deadline) {
+    if ( ! state.active) {
+        return;
+    }
 
-    // Enable the TC interrupt vector
-    // Set the priority to max
-    if (tc == TC4) {
-        NVIC_ClearPendingIRQ(TC4_IRQn);
-        NVIC_EnableIRQ (TC4_IRQn);
-        NVIC_SetPriority(TC4_IRQn, 0x00);
-    } else if (tc == TC5) {
-        NVIC_ClearPendingIRQ(TC5_IRQn);
-        NVIC_EnableIRQ (TC5_IRQn);
-        NVIC_SetPriority(TC5_IRQn, 0x00);
+    // Wait for an earlier CC0 write with interrupts enabled, so armCompare rarely has to.
+    waitSync(tc);
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    state.deadline = deadline;
+    state.armed = true;
+    armCompare(tc, state);
+    __set_PRIMASK(primask);
+}
+
+/**
+ * Cancel the tickless deadline of a TC.
+ *
+ * @param tc The TC, must be TC4 or TC5.
+ * @param state The tickless state of the TC.
+ */
+void clearDeadline(Tc* tc, TicklessState& state) {
+    state.armed = false;
+    tc->COUNT16.INTENCLR.reg = TC_INTENCLR_MC0;
+}
+
+/**
+ * Set CC0 to the low 16 bits of the deadline and enable the CC0 interrupt.
+ *
+ * A deadline more than 0x10000 ticks away causes an early CC0 match, which
+ * just results in this being called again.
+ *
+ * CC0 is only written if its value changes, eg not when a far deadline is
+ * rearmed for the next pass of the count, and only once an earlier write has
+ * been synchronised, so a second write in quick succession polls instead of
+ * stalling the bus.
+ *
+ * Must be called with interrupts disabled.
+ *
+ * @param tc The TC, must be TC4 or TC5.
+ * @param state The tickless state of the TC.
+ */
+void armCompare(Tc* tc, TicklessState& state) {
+    uint32_t target = state.deadline;
+    uint32_t ticks = readTicks(tc, state);
+
+    // Don't set a compare value the count may pass before the write is synchronised.
+    if ((int32_t)(target - ticks) < (int32_t)state.leadTicks) {
+        target = ticks + state.leadTicks;
+    }
+
+    tc->COUNT16.INTFLAG.reg = TC_INTFLAG_MC0;
+    if ( ! state.compareValid || state.compare != (uint16_t)target) {
+        waitSync(tc);
+        tc->COUNT16.CC[0].reg = (uint16_t)target;
+        state.compare = (uint16_t)target;
+        state.compareValid = true;
+    }
+    tc->COUNT16.INTENSET.reg = TC_INTENSET_MC0;
+}
+
+// halfEpochWraps is incremented after halfEpochs wraps, so readTicks64 sees the change and reads again.
+static inline void countHalfEpoch(TicklessState& state) {
+    if (++state.halfEpochs == 0) {
+        state.halfEpochWraps++;
+    }
+}
+
+/**
+ * Handles the overflow, half-way and CC0 interrupts of a TC in tickless mode.
+ *
+ * @param tc The TC, must be TC4 or TC5.
+ * @param state The tickless state of the TC.
+ * @param callback The function to call when the deadline is reached.
+ */
+void handleTicklessInterrupt(Tc* tc, TicklessState& state, TimerCallback& callback) {
+    uint8_t flags = tc->COUNT16.INTFLAG.reg;
+
+    // Clear the flags by writing 1s before acting on them so nothing that happens after this point is lost.
+    tc->COUNT16.INTFLAG.reg = flags & (TC_INTFLAG_OVF | TC_INTFLAG_MC0 | TC_INTFLAG_MC1);
+
+    if (flags & TC_INTFLAG_OVF) {
+        countHalfEpoch(state);
+    }
+
+    if (flags & TC_INTFLAG_MC1) {
+        countHalfEpoch(state);
+    }
+
+    if ((flags & TC_INTFLAG_MC0) && state.armed) {
+        int32_t remaining = state.deadline - readTicks(tc, state);
+        if (remaining > 0) {
+            // The deadline is in a later pass of the 16-bit count.
+            armCompare(tc, state);
+        } else {
+            // Disarm first so the callback can set the next deadline.
+            state.armed = false;
+            tc->COUNT16.INTENCLR.reg = TC_INTENCLR_MC0;
+
+            // A deadline set too close to be seen on time is late by up to leadTicks.
+            if (-remaining > state.leadTicks) {
+                callback.missed++;
+            }
+
+            dispatch(callback);
+        }
+    }
+}
+
+/**
+ * Returns the TC prescaler setting of TC4 or TC5.
+ *
+ * @param tc Must be TC4 or TC5.
+ */
+uint8_t ZeroTC45::prescaler(Tc* tc) {
+    return (tc == TC5) ? tc5Prescaler : clock.prescaler;
+}
+
+/**
+ * Returns the rate of the units the periods of TC4 or TC5 are given in,
+ * which is the tick rate unless the periods are scaled.
+ *
+ * @param tc Must be TC4 or TC5.
+ */
+uint32_t ZeroTC45::timingHz(Tc* tc) {
+    TimerCallback& callback = (tc == TC4) ? tc4Callback : tc5Callback;
+    if (callback.unitsPerTick != 0) {
+        return (uint64_t)tickHz((tc == TC4) ? getClockConfig() : getTc5ClockConfig()) * callback.unitsPerTick / callback.ticksPerUnit;
+    }
+
+    return tickHz((tc == TC4) ? getClockConfig() : getTc5ClockConfig());
+}
+
+/**
+ * Check a clock configuration can be written to a GCLK generator as it is.
+ * GENDIV is written with DIVSEL 0, so the divisor is the DIV field, which is
+ * 16 bits wide for GCLK 1, 5 bits for GCLK 2 and 8 bits for the others.
+ *
+ * @param config The clock configuration.
+ * @param gclkId The GCLK generator.
+ * @return true if the configuration gives a tick rate of at least 1Hz from the GCLK.
+ */
+boolean validClock(ZeroTC45::ClockConfig config, uint8_t gclkId) {
+    if (gclkId == 0 || gclkId >= GCLK_GEN_NUM) {
+        return false;
+    }
+
+    uint16_t maxDivisor = (gclkId == 1) ? 0xFFFF : (gclkId == 2) ? 31 : 255;
+    if (config.gclkDivisor == 0 || config.gclkDivisor > maxDivisor) {
+        return false;
+    }
+
+    if (config.source > ZeroTC45::DFLL48M || config.prescaler > 7) {
+        return false;
     }
+
+    return ZeroTC45::tickHz(config) != 0;
 }
 
 /**
- * Configure the given generic clock source to emit a 1kHz signal.
+ * Configure the given generic clock source to emit the GCLK frequency of the
+ * clock configuration given to begin.
  *
- * The source is driven by the external 32kHz crystal and uses a
- * 32 prescaler to bring it down to 1kHz.
+ * For the 32kHz sources the GCLK is usually 1kHz (32kHz / 32) and the TC
+ * prescaler does any further division. For DFLL48M and OSC8M the GCLK runs
+ * at the source frequency divided by gclkDivisor.
  *
  * It links the genric clock source to TC4/TC5.
  *
@@ -224,65 +2461,575 @@ void ZeroTC45::configureTC(Tc* tc, uint16_t period, boolean oneShot) {
  */
 void ZeroTC45::configureGclk(uint8_t gclkId) {
 
-    if (resolution == SECONDS) {
-        // Configure the 32768 Hz oscillator when counting seconds.
-        SYSCTRL->XOSC32K.reg = SYSCTRL_XOSC32K_ONDEMAND |
-                               SYSCTRL_XOSC32K_RUNSTDBY |
-                               SYSCTRL_XOSC32K_EN32K |
-                               SYSCTRL_XOSC32K_XTALEN | SYSCTRL_XOSC32K_STARTUP(6) |
-                               SYSCTRL_XOSC32K_ENABLE;
+    uint32_t src = GCLK_GENCTRL_SRC_OSCULP32K;
+
+    switch (clock.source) {
+        case XOSC32K: {
+            // Configure the 32768 Hz crystal oscillator, unless it is already running, eg from an
+            // earlier begin or from RTCZero. Writing XOSC32K restarts the crystal, which takes
+            // STARTUP(6) (about 2 seconds) and stops the clock of anything else using it meanwhile.
+            uint16_t xosc32k = SYSCTRL->XOSC32K.reg;
+            uint16_t running = SYSCTRL_XOSC32K_ENABLE | SYSCTRL_XOSC32K_XTALEN | SYSCTRL_XOSC32K_EN32K;
+            if ((xosc32k & running) != running) {
+                SYSCTRL->XOSC32K.reg = SYSCTRL_XOSC32K_ONDEMAND |
+                                       SYSCTRL_XOSC32K_RUNSTDBY |
+                                       SYSCTRL_XOSC32K_EN32K |
+                                       SYSCTRL_XOSC32K_XTALEN | SYSCTRL_XOSC32K_STARTUP(6) |
+                                       SYSCTRL_XOSC32K_ENABLE;
+            } else if ( ! (xosc32k & SYSCTRL_XOSC32K_RUNSTDBY)) {
+                // The TCs run in standby so the crystal has to as well. This doesn't restart it.
+                SYSCTRL->XOSC32K.bit.RUNSTDBY = 1;
+            }
+            src = GCLK_GENCTRL_SRC_XOSC32K;
+            break;
+        }
+
+        case OSC8M:
+            // The Arduino core leaves OSC8M running at 8MHz, but make sure it is enabled.
+            if ( ! SYSCTRL->OSC8M.bit.ENABLE) {
+                SYSCTRL->OSC8M.bit.ENABLE = 1;
+                while ( ! SYSCTRL->PCLKSR.bit.OSC8MRDY);
+            }
+            src = GCLK_GENCTRL_SRC_OSC8M;
+            break;
+
+        case DFLL48M:
+            src = GCLK_GENCTRL_SRC_DFLL48M;
+            break;
+
+        case OSCULP32K:
+            src = GCLK_GENCTRL_SRC_OSCULP32K;
+            break;
     }
 
     //========== GCLK configuration - this is the source clock for the TC.
 
-    // Setup clock provider gclkId with a 32 source divider
+    // Each register below is only written if it changes, so calling begin again with the same
+    // resolution doesn't stop the clock at all. The GCLK registers are read by first writing
+    // the ID of the generator or clock to their low byte, in a single 8-bit write.
+
+    // Setup clock provider gclkId with the source divider
     // GCLK_GENDIV_ID(X) specifies which GCLK we are configuring
     // GCLK_GENDIV_DIV(Y) specifies the clock prescalar / divider
-    // If GENCTRL.DIVSEL is set (see further below) the divider
-    // is 2^(Y+1). If GENCTRL.DIVSEL is 0, the divider is simply Y
+    // GENCTRL.DIVSEL is 0 (see further below) so the divider is simply Y.
     // This register has to be written in a single operation.
-    GCLK->GENDIV.reg = GCLK_GENDIV_ID(gclkId) | GCLK_GENDIV_DIV(4);  // This divisor works for both seconds and milliseconds.
+    uint32_t gendiv = GCLK_GENDIV_ID(gclkId) | GCLK_GENDIV_DIV(clock.gclkDivisor);
+    *((volatile uint8_t*)&GCLK->GENDIV.reg) = gclkId;
+    if (GCLK->GENDIV.reg != gendiv) {
+        GCLK->GENDIV.reg = gendiv;
+    }
     // GENDIV is not write sync
 
     // Configure the GCLK module
-    // With this configuration the output from this module is 1khz (32khz / 32)
     // This register has to be written in a single operation.
     while (GCLK->STATUS.bit.SYNCBUSY);
-    
+
     uint32_t genctrl = GCLK_GENCTRL_GENEN          // GCLK_GENCTRL_GENEN, enable the specific GCLK module
                       | GCLK_GENCTRL_ID(gclkId)    // GCLK_GENCTRL_ID(X), specifies which GCLK is being configured
-                      | GCLK_GENCTRL_DIVSEL;       // GCLK_GENCTRL_DIVSEL, specify the divider is 2^(GENDIV.DIV+1)
+                      | src;                       // The oscillator for the clock configuration.
 
-    // For seconds, use a 32.768 khz source with dividers 32 and 1024.
-    // For milliseconds, use a 32 khz source with a divider of 32.
-    genctrl |= (resolution == SECONDS) ? GCLK_GENCTRL_SRC_XOSC32K : GCLK_GENCTRL_SRC_OSCULP32K;
-    
-    GCLK->GENCTRL.reg = genctrl;
+    *((volatile uint8_t*)&GCLK->GENCTRL.reg) = gclkId;
     while (GCLK->STATUS.bit.SYNCBUSY);
+    if (GCLK->GENCTRL.reg != genctrl) {
+        GCLK->GENCTRL.reg = genctrl;
+        while (GCLK->STATUS.bit.SYNCBUSY);
+    }
 
     // Set TC4 (shared with TC5) GCLK source to gclkId
-    GCLK->CLKCTRL.reg = GCLK_CLKCTRL_CLKEN              // GCLK_CLKCTRL_CLKEN, enable the generic clock
-                      | GCLK_CLKCTRL_GEN(gclkId)        // GCLK_CLKCTRL_GEN(X), specifies the GCLK generator source
-                      | GCLK_CLKCTRL_ID(GCM_TC4_TC5);   // GCLK_CLKCTRL_ID(X), specifies which TC this GCLK is being fed to
+    uint16_t clkctrl = GCLK_CLKCTRL_CLKEN              // GCLK_CLKCTRL_CLKEN, enable the generic clock
+                     | GCLK_CLKCTRL_GEN(gclkId)        // GCLK_CLKCTRL_GEN(X), specifies the GCLK generator source
+                     | GCLK_CLKCTRL_ID(GCM_TC4_TC5);   // GCLK_CLKCTRL_ID(X), specifies which TC this GCLK is being fed to
+
+    *((volatile uint8_t*)&GCLK->CLKCTRL.reg) = GCM_TC4_TC5;
+    if (GCLK->CLKCTRL.reg == clkctrl) {
+        return;
+    }
+
+    GCLK->CLKCTRL.reg = clkctrl;
     while (GCLK->STATUS.bit.SYNCBUSY);
 }
 
+/**
+ * Set the period that the statistics of a timer are checked against, and
+ * start timing from now.
+ *
+ * @param callback The callback record of the timer.
+ * @param period The period in ticks, or 0 if the timer doesn't fire periodically.
+ * @param hz The tick rate of the timer.
+ */
+void setTiming(TimerCallback& callback, uint32_t period, uint32_t hz) {
+    uint64_t cycles = (hz == 0) ? 0 : (uint64_t)period * SystemCoreClock / hz;
+
+    // The cycle count wraps after 2^32 clocks, so longer periods can't be checked.
+    callback.periodCycles = (cycles < 0x80000000UL) ? (uint32_t)cycles : 0;
+    callback.lastFire = statsCycles();
+}
+
+/**
+ * Set how periods are converted to ticks: ticksPerUnit / unitsPerTick ticks
+ * per unit of the period. If unitsPerTick is 0 periods are in ticks. The
+ * calibration correction is cleared.
+ */
+void setScale(TimerCallback& callback, uint32_t ticksPerUnit, uint32_t unitsPerTick) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    callback.resolutionTicks = ticksPerUnit;
+    callback.resolutionUnits = unitsPerTick;
+    callback.correctionPpb = 0;
+    callback.ticksPerUnit = ticksPerUnit;
+    callback.unitsPerTick = unitsPerTick;
+    callback.remainder = 0;
+    callback.accumulator = 0;
+    callback.corrected = false;
+    callback.period = 0;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * Set the calibration correction of a timer, and convert the period of a
+ * running timer again so it applies from the next period on.
+ *
+ * With a correction the ratio has a denominator of 10^9, so it is exact to
+ * 1 part per billion.
+ *
+ * @param callback The state of the timer.
+ * @param ppb How fast the timer clock runs, in parts per billion. Positive if it is fast.
+ */
+void setCorrection(TimerCallback& callback, int32_t ppb) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    callback.correctionPpb = ppb;
+
+    if (ppb == 0) {
+        callback.ticksPerUnit = callback.resolutionTicks;
+        callback.unitsPerTick = callback.resolutionUnits;
+    } else {
+        uint64_t ticks = (callback.resolutionUnits != 0) ? callback.resolutionTicks : 1;
+        uint64_t units = (callback.resolutionUnits != 0) ? callback.resolutionUnits : 1;
+
+        // A fast clock has more ticks in each unit of time.
+        callback.ticksPerUnit = (ticks * (1000000000LL + ppb) + units / 2) / units;
+        callback.unitsPerTick = 1000000000UL;
+    }
+
+    if (callback.period != 0) {
+        convertPeriod(callback);
+    }
+
+    __set_PRIMASK(primask);
+}
+
+/**
+ * Work out baseTicks and the correction for the period in callback.period.
+ * Must be called with interrupts disabled.
+ *
+ * The correction is only made for periodic timers of at least
+ * COMPARE_SYNC_CLOCKS ticks, because CC0 is written at the start of each
+ * period and the count mustn't pass it before the write is synchronised.
+ * Shorter periods and one-shots are rounded to the nearest tick.
+ */
+void convertPeriod(TimerCallback& callback) {
+    callback.remainder = 0;
+    callback.accumulator = 0;
+    callback.corrected = false;
+
+    uint32_t ticks = callback.period;
+    if (callback.unitsPerTick != 0) {
+        uint64_t scaled = (uint64_t)callback.period * callback.ticksPerUnit;
+        uint64_t whole = scaled / callback.unitsPerTick;
+
+        if (callback.oneShot || whole < COMPARE_SYNC_CLOCKS || whole >= callback.maxTicks) {
+            whole = (scaled + callback.unitsPerTick / 2) / callback.unitsPerTick;
+        } else {
+            callback.remainder = scaled % callback.unitsPerTick;
+            callback.corrected = true;
+        }
+
+        ticks = (whole > callback.maxTicks) ? callback.maxTicks : (uint32_t)whole;
+    }
+
+    if (ticks == 0) {
+        ticks = 1;
+    }
+
+    callback.baseTicks = ticks;
+}
+
+/**
+ * Convert a period to ticks, and set up the correction of the fraction of a
+ * tick that is left over. See convertPeriod.
+ *
+ * @param callback The state of the timer.
+ * @param period The period in the units of the timer.
+ * @param oneShot True if the timer only fires once.
+ * @param maxTicks The largest period the counter can make.
+ * @return The number of ticks of the first period, at least 1.
+ */
+uint32_t scalePeriod(TimerCallback& callback, uint32_t period, boolean oneShot, uint32_t maxTicks) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    callback.period = period;
+    callback.oneShot = oneShot;
+    callback.maxTicks = maxTicks;
+    convertPeriod(callback);
+    uint32_t ticks = callback.baseTicks;
+
+    __set_PRIMASK(primask);
+    return ticks;
+}
+
+/**
+ * Copy the statistics of a timer with interrupts disabled, so they are all from the same moment.
+ */
+ZeroTC45::Stats getStats(const TimerCallback& callback) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    ZeroTC45::Stats stats = { callback.count, callback.overruns, callback.missed, callback.maxCycles };
+    __set_PRIMASK(primask);
+    return stats;
+}
+
+void resetStats(TimerCallback& callback) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    callback.count = 0;
+    callback.overruns = 0;
+    callback.missed = 0;
+    callback.maxCycles = 0;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * Replace a timer callback. Interrupts are disabled while the fields are
+ * written so the interrupt handler never sees a half-written callback.
+ */
+void setCallback(TimerCallback& callback, voidFuncPtr function, contextFuncPtr contextFunction, void* context) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    callback.function = function;
+    callback.contextFunction = contextFunction;
+    callback.context = context;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * Enable or disable the overflow interrupt of a running periodic TC after
+ * its callback changes. Tickless mode always needs its interrupts, and a
+ * stopped TC has them disabled already.
+ *
+ * @param tc The TC to update, must be TC4 or TC5.
+ * @param state The tickless state of the TC.
+ * @param callback The new callback.
+ */
+void updateOverflowInterrupt(Tc* tc, TicklessState& state, const TimerCallback& callback) {
+    if (state.active || ! tc->COUNT16.CTRLA.bit.ENABLE || tc->COUNT16.STATUS.bit.STOP) {
+        return;
+    }
+
+    if (hasCallback(callback)) {
+        tc->COUNT16.INTENSET.reg = TC_INTENSET_OVF;
+    } else {
+        tc->COUNT16.INTENCLR.reg = TC_INTENCLR_OVF;
+    }
+}
+
+/**
+ * Turn on the TC event outputs that connected event channels use, and turn
+ * off the others. EVCTRL is not synchronised.
+ *
+ * @param tc The TC to update, must be TC4 or TC5.
+ * @param firstGenerator The EVSYS_ID_GEN_ value of the TC overflow event, the first of its events.
+ */
+void updateEventOutputs(Tc* tc, uint8_t firstGenerator) {
+    static const uint16_t outputs[] = { TC_EVCTRL_OVFEO, TC_EVCTRL_MCEO0, TC_EVCTRL_MCEO1 };
+
+    uint16_t evctrl = 0;
+    for (uint8_t channel = 0; channel < EVSYS_CHANNELS; channel++) {
+        uint8_t event = eventGenerators[channel] - firstGenerator;
+        if ((usedEventChannels & (1 << channel)) && event < 3) {
+            evctrl |= outputs[event];
+        }
+    }
+
+    uint16_t mask = TC_EVCTRL_OVFEO | TC_EVCTRL_MCEO0 | TC_EVCTRL_MCEO1;
+    tc->COUNT16.EVCTRL.reg = (tc->COUNT16.EVCTRL.reg & ~mask) | evctrl;
+}
+
+/**
+ * Disconnect the event given to startTc4OnEvent or startTc4Capture, if there
+ * is one, turn off the TC event input and end capture mode.
+ *
+ * @param tc The TC, must be TC4 or TC5.
+ */
+void releaseInputEvent(Tc* tc) {
+    CaptureState& capture = (tc == TC4) ? tc4Capture : tc5Capture;
+    capture.active = false;
+
+    // CTRLC is only written in capture mode, and can be read without synchronisation.
+    if (tc->COUNT16.CTRLC.reg != 0) {
+        waitSync(tc);
+        tc->COUNT16.CTRLC.reg = 0;
+    }
+
+    int8_t& channel = (tc == TC4) ? tc4InputChannel : tc5InputChannel;
+    if (channel < 0) {
+        return;
+    }
+
+    tc->COUNT16.EVCTRL.reg &= ~(TC_EVCTRL_TCEI | TC_EVCTRL_EVACT_Msk);
+    ZeroTC45::disconnectEvent(channel);
+    channel = -1;
+}
+
+/**
+ * Find the waveform output of a TC that can drive a pin.
+ *
+ * @param tc The TC, must be TC4 or TC5.
+ * @param pin The Arduino pin number.
+ * @return 0 for WO0, 1 for WO1, or -1 if the TC can't drive the pin.
+ */
+int8_t pwmOutput(Tc* tc, uint8_t pin) {
+    uint8_t number = (tc == TC4) ? 4 : 5;
+    const PinDescription& description = g_APinDescription[pin];
+
+    for (uint8_t i = 0; i < sizeof(pwmPins) / sizeof(pwmPins[0]); i++) {
+        if (pwmPins[i].tc == number && pwmPins[i].port == description.ulPort && pwmPins[i].pin == description.ulPin) {
+            return pwmPins[i].output;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * Give the pins driven by a TC in PWM mode back to the port as low
+ * outputs, so they don't follow the TC once it is used another way.
+ *
+ * @param tc The TC, must be TC4 or TC5.
+ */
+void releasePwm(Tc* tc) {
+    int8_t* pins = (tc == TC4) ? tc4PwmPins : tc5PwmPins;
+
+    for (uint8_t i = 0; i < 2; i++) {
+        if (pins[i] >= 0) {
+            pinMode(pins[i], OUTPUT);
+            digitalWrite(pins[i], LOW);
+            pins[i] = -1;
+        }
+    }
+}
+
+/**
+ * Read a capture. CC0 and CC1 are read synchronised like COUNT, so the read
+ * is requested and waited for, a few clocks of the TC's GCLK.
+ *
+ * @param tc The TC, in capture mode.
+ * @param channel The compare channel, 0 or 1.
+ */
+static inline uint16_t readCapture(Tc* tc, uint8_t channel) {
+    waitSync(tc);
+    tc->COUNT16.READREQ.reg = TC_READREQ_RREQ | TC_READREQ_ADDR(TC_COUNT16_CC_OFFSET + channel * 2);
+    waitSync(tc);
+    return tc->COUNT16.CC[channel].reg;
+}
+
+/**
+ * Handle a TC interrupt in capture mode. The pair is complete at the second
+ * edge of each pulse, when the second compare channel captures. The counter
+ * only overflows if no pulse starts for a whole 16-bit count.
+ */
+void handleCaptureInterrupt(Tc* tc, CaptureState& capture, TimerCallback& callback) {
+    uint8_t flags = tc->COUNT16.INTFLAG.reg;
+
+    if (flags & TC_INTFLAG_OVF) {
+        tc->COUNT16.INTFLAG.reg = TC_INTFLAG_OVF;
+        capture.period = 0;
+        capture.width = 0;
+        capture.fresh = true;
+    }
+
+    if (flags & capture.lastFlag) {
+        uint16_t cc0 = readCapture(tc, 0);
+        uint16_t cc1 = readCapture(tc, 1);
+        tc->COUNT16.INTFLAG.reg = TC_INTFLAG_MC0 | TC_INTFLAG_MC1;
+
+        // PPW captures the period into CC0 and the width into CC1, PWP the other way round.
+        boolean ppw = (capture.lastFlag == TC_INTFLAG_MC1);
+        capture.period = ppw ? cc0 : cc1;
+        capture.width = ppw ? cc1 : cc0;
+        capture.fresh = true;
+
+        dispatch(callback);
+    }
+}
+
+/**
+ * @return true if the TC is running and will interrupt and call dispatch, so it can wake the CPU.
+ */
+boolean willFire(Tc* tc, const TicklessState& state, const TimerCallback& callback) {
+    if ( ! hasCallback(callback)) {
+        return false;
+    }
+
+    if (state.active) {
+        return state.armed;
+    }
+
+    // A stopped TC or a finished one-shot has STOP set. None of these registers are synchronised.
+    return (tc->COUNT16.CTRLA.reg & TC_CTRLA_ENABLE)
+        && (tc->COUNT16.INTENSET.reg & TC_INTENSET_OVF)
+        && ! tc->COUNT16.STATUS.bit.STOP;
+}
+
+/**
+ * Read the count of a periodic TC. configureTC sets the count to be read
+ * continuously, so this is just a register read. Otherwise a read request
+ * is made and waited for, which would end a continuous read, so this is not
+ * for tickless mode.
+ *
+ * @param tc The TC to read, must be TC4 or TC5.
+ * @param wide True if TC4 is in 32-bit mode.
+ * @return The count.
+ */
+uint32_t readCount(Tc* tc, boolean wide) {
+    // COUNT has the same offset in 16 and 32-bit mode. READREQ can be read without synchronisation.
+    if (tc->COUNT16.READREQ.reg != (TC_READREQ_RCONT | TC_READREQ_ADDR(TC_COUNT16_COUNT_OFFSET))) {
+        waitSync(tc);
+        tc->COUNT16.READREQ.reg = TC_READREQ_RREQ | TC_READREQ_ADDR(TC_COUNT16_COUNT_OFFSET);
+        while (tc->COUNT16.STATUS.bit.SYNCBUSY);
+    }
+
+    return wide ? tc->COUNT32.COUNT.reg : tc->COUNT16.COUNT.reg;
+}
+
+/**
+ * Keep the count of a TC continuously synchronised, so readCount doesn't
+ * have to make a read request and wait for it each time. A read request is
+ * a synchronised write, so it is only made if it isn't already set up.
+ *
+ * The continuously read count lags the real count by a few TC clocks.
+ *
+ * @param tc The TC, must be TC4 or TC5.
+ */
+void readContinuously(Tc* tc) {
+    uint16_t readreq = TC_READREQ_RCONT | TC_READREQ_ADDR(TC_COUNT16_COUNT_OFFSET);
+    if (tc->COUNT16.READREQ.reg != readreq) {
+        waitSync(tc);
+        tc->COUNT16.READREQ.reg = readreq;
+    }
+}
+
+/**
+ * Work out how far a periodic TC is through its period, in the units of the
+ * period given to startTc4.
+ *
+ * @param tc The TC, must be TC4 or TC5.
+ * @param callback The state of the timer.
+ * @param top The CC0 value of the TC in 16-bit mode.
+ * @param remaining If true return the time to the end of the period, otherwise the time since its start.
+ * @return The time, or 0 if the TC isn't running a period.
+ */
+uint32_t periodPosition(Tc* tc, const TimerCallback& callback, uint16_t top, boolean remaining) {
+    const TicklessState& state = (tc == TC4) ? tc4Tickless : tc5Tickless;
+    const CaptureState& capture = (tc == TC4) ? tc4Capture : tc5Capture;
+
+    // A stopped TC or a finished one-shot has STOP set. None of these registers are synchronised.
+    if (state.active || capture.active
+            || ! (tc->COUNT16.CTRLA.reg & TC_CTRLA_ENABLE) || tc->COUNT16.STATUS.bit.STOP) {
+        return 0;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t count = readCount(tc, callback.wide);
+    uint32_t end = callback.wide ? tc4Top32 : top;
+    __set_PRIMASK(primask);
+
+    // The count can be past a CC0 that was just lowered, until it wraps.
+    uint32_t ticks = remaining ? ((count <= end) ? end + 1 - count : 0) : count;
+
+    if (callback.unitsPerTick == 0) {
+        return ticks;
+    }
+    return (uint64_t)ticks * callback.unitsPerTick / callback.ticksPerUnit;
+}
+
+/**
+ * The deferred interrupt, pended by dispatch for the timers set up with
+ * setTc4Deferred. It runs at the priority given to setDeferredPriority, so
+ * a long callback only holds up interrupts of the same or lower priority.
+ */
+static void runDeferred(TimerCallback& callback) {
+    while (callback.deferredCalls != 0) {
+        // The TC interrupt can preempt this, so the decrement is made with interrupts disabled.
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        callback.deferredCalls--;
+        __set_PRIMASK(primask);
+
+        callFunction(callback, statsCycles());
+    }
+}
+
+/**
+ * Make the deferred calls of both timers. Called by the deferred interrupt
+ * handler in ZeroTC45Deferred.cpp.
+ */
+void ZeroTC45::handleDeferredInterrupt() {
+    runDeferred(tc4Callback);
+    runDeferred(tc5Callback);
+}
+
 void TC4_Handler() {
-    if (TC4->COUNT16.INTFLAG.reg & TC_INTFLAG_OVF) {
-        if (tc4Callback != NULL) {
-            tc4Callback();
+    TRACE_EVENT(ENTER, TC4);
+
+    if (tc4Tickless.active) {
+        handleTicklessInterrupt(TC4, tc4Tickless, tc4Callback);
+    } else if (tc4Capture.active) {
+        handleCaptureInterrupt(TC4, tc4Capture, tc4Callback);
+    } else if (TC4->COUNT16.INTFLAG.reg & TC_INTFLAG_OVF) {
+        // Clear the flag by writing a 1 before the callback, so an overflow during the callback isn't lost.
+        // A read-modify-write would also clear any other flag that was set.
+        TC4->COUNT16.INTFLAG.reg = TC_INTFLAG_OVF;
+
+        if (tc4Callback.corrected) {
+            correctPeriod(TC4, tc4Callback, tc4Top);
         }
 
-        TC4->COUNT16.INTFLAG.reg |= TC_INTFLAG_OVF;
+        if (tc4Callback.burstRemaining != 0) {
+            countBurst(TC4, tc4Callback);
+        }
+
+        dispatch(tc4Callback);
     }
+
+    TRACE_EVENT(EXIT, TC4);
 }
 
 void TC5_Handler() {
-    if (TC5->COUNT16.INTFLAG.reg & TC_INTFLAG_OVF) {
-        if (tc5Callback != NULL) {
-            tc5Callback();
+    TRACE_EVENT(ENTER, TC5);
+
+    if (tc5Tickless.active) {
+        handleTicklessInterrupt(TC5, tc5Tickless, tc5Callback);
+    } else if (tc5Capture.active) {
+        handleCaptureInterrupt(TC5, tc5Capture, tc5Callback);
+    } else if (TC5->COUNT16.INTFLAG.reg & TC_INTFLAG_OVF) {
+        // Clear the flag by writing a 1 before the callback, so an overflow during the callback isn't lost.
+        // A read-modify-write would also clear any other flag that was set.
+        TC5->COUNT16.INTFLAG.reg = TC_INTFLAG_OVF;
+
+        if (tc5Callback.corrected) {
+            correctPeriod(TC5, tc5Callback, tc5Top);
+        }
+
+        if (tc5Callback.burstRemaining != 0) {
+            countBurst(TC5, tc5Callback);
         }
 
-        TC5->COUNT16.INTFLAG.reg |= TC_INTFLAG_OVF;
+        dispatch(tc5Callback);
     }
+
+    TRACE_EVENT(EXIT, TC5);
 }
@@ -23,12 +23,77 @@
 #include "Arduino.h"
 
 typedef void(*voidFuncPtr)(void);
+typedef void(*contextFuncPtr)(void* context);
+
+class ZeroTC45Queue;
 
 class ZeroTC45 {
 
 public:
-    /// Valid resolutions for the timers. Both timers will use the selected resolution.
-    enum Resolution { MILLISECONDS, SECONDS };
+    /// Valid resolutions for the timers.
+    enum Resolution { MILLISECONDS, SECONDS, MICROSECONDS, CRYSTAL_MILLISECONDS };
+
+    /// TC events that can be routed to other peripherals with the event system. The order matches the EVSYS generator ids.
+    enum TcEvent { OVERFLOW_EVENT, MATCH0_EVENT, MATCH1_EVENT };
+
+    /// Which CC register the period of a pulse is captured into, and which the width.
+    enum CaptureMode { CAPTURE_PPW, CAPTURE_PWP };
+
+    /// The oscillators that can drive the GCLK used by TC4 and TC5.
+    enum ClockSource { OSCULP32K, XOSC32K, OSC8M, DFLL48M };
+
+    /**
+     * The clock settings that give a tick rate: the oscillator, the GCLK
+     * divisor and the TC prescaler. Make one with tickRate, or with
+     * ZeroTC45TickRate to have an impossible rate rejected at compile time.
+     */
+    struct ClockConfig {
+        ClockSource source;
+        uint16_t gclkDivisor;       // 1 - 255 (31 on GCLK 2), or 0 if the tick rate can't be made from the source.
+        uint8_t prescaler;          // The TC CTRLA.PRESCALER value, 0 (DIV1) - 7 (DIV1024).
+    };
+
+    /// Timing statistics of a timer, from getTc4Stats or getTc5Stats.
+    struct Stats {
+        uint32_t fires;             // The number of times the timer fired.
+        uint32_t overruns;          // Callbacks that took longer than the period.
+        uint32_t missed;            // Overflows lost because the interrupt was too late, or tickless deadlines reached late.
+        uint32_t maxCallbackCycles; // The longest callback in CPU clocks.
+    };
+
+    /// Returns the frequency of a clock source in Hz.
+    static constexpr uint32_t sourceHz(ClockSource source) {
+        return (source == DFLL48M) ? 48000000UL : (source == OSC8M) ? 8000000UL : 32768UL;
+    }
+
+    /// Returns how many GCLK clocks the TC prescaler setting divides by.
+    static constexpr uint16_t prescalerDivision(uint8_t prescaler) {
+        return (prescaler <= 4) ? (1 << prescaler) : (prescaler == 5) ? 64 : (prescaler == 6) ? 256 : 1024;
+    }
+
+    /// Returns the tick rate in Hz of a clock configuration, rounded down.
+    static constexpr uint32_t tickHz(ClockConfig config) {
+        return (config.gclkDivisor == 0) ? 0 : sourceHz(config.source) / ((uint32_t)config.gclkDivisor * prescalerDivision(config.prescaler));
+    }
+
+    /**
+     * Returns the clock configuration that makes exactly hz ticks per second
+     * from the given source, with the largest prescaler possible. The
+     * gclkDivisor is 0 if there is no exact configuration.
+     *
+     * This is constexpr so it can be evaluated by the compiler.
+     */
+    static constexpr ClockConfig tickRate(uint32_t hz, ClockSource source = DFLL48M) {
+        return findTickRate(hz, source, 7);
+    }
+
+    /// Returns the clock configuration used for a resolution.
+    static constexpr ClockConfig resolutionConfig(Resolution resolution) {
+        return (resolution == SECONDS)      ? ClockConfig { XOSC32K, 32, 7 }     // 32768 / 32 / 1024 = 1Hz
+             : (resolution == MICROSECONDS) ? ClockConfig { DFLL48M, 48, 0 }     // 48MHz / 48 = 1MHz
+             : (resolution == CRYSTAL_MILLISECONDS) ? ClockConfig { XOSC32K, 32, 0 }  // 32768 / 32 = 1024Hz, scaled to 1000Hz
+             :                                ClockConfig { OSCULP32K, 32, 0 };  // 32768 / 32 = 1024Hz
+    }
     
     /**
      * Create an instance of the ZeroTC45 class.
@@ -38,11 +103,41 @@ public:
      */
     ZeroTC45() {};
 
-    /// Initialise the ZeroTC45 object. This must be called before any other methods.
-    void begin(uint8_t gclkId = 4);
+    /// Initialise the ZeroTC45 object. This must be called before any other methods. Returns false if the GCLK can't be used.
+    boolean begin(uint8_t gclkId = 4);
 
     /// Initialise the ZeroTC45 object to use the given resolution. Both timers will use this resolution. This must be called before any other methods.
-    void begin(Resolution resoluion, uint8_t gclkId = 4);
+    boolean begin(Resolution resoluion, uint8_t gclkId = 4);
+
+    /// Initialise the ZeroTC45 object to use the given clock configuration for both timers. Returns false if the configuration isn't valid.
+    boolean begin(ClockConfig config, uint8_t gclkId = 4);
+
+    /// Initialise the ZeroTC45 object with a different resolution for each timer. Returns false if the resolutions can't share a GCLK.
+    boolean begin(Resolution tc4Resolution, Resolution tc5Resolution, uint8_t gclkId = 4);
+
+    /// Initialise the ZeroTC45 object with a different clock configuration for each timer. They must differ only in the prescaler.
+    boolean begin(ClockConfig tc4Config, ClockConfig tc5Config, uint8_t gclkId = 4);
+
+    /// Stop both timers and change their resolution without the rest of begin. Returns false if the resolutions can't share a GCLK.
+    boolean setResolution(Resolution resolution);
+
+    /// Stop both timers and give each a new resolution. Returns false if the resolutions can't share a GCLK.
+    boolean setResolution(Resolution tc4Resolution, Resolution tc5Resolution);
+
+    /// Stop TC4 and change its resolution by changing only its prescaler. Returns false if it needs a different GCLK.
+    boolean setTc4Resolution(Resolution resolution);
+
+    /// Stop TC5 and change its resolution by changing only its prescaler. Returns false if it needs a different GCLK.
+    boolean setTc5Resolution(Resolution resolution);
+
+    /// Returns the TC4 clock configuration given to begin.
+    ClockConfig getClockConfig();
+
+    /// Returns the TC5 clock configuration given to begin.
+    ClockConfig getTc5ClockConfig();
+
+    /// Returns the GCLK given to begin, for the other timers clocked from it.
+    uint8_t getGclkId();
 
     /// Set the callback function for the TC4 interrupt.
     void setTc4Callback(voidFuncPtr callback);
@@ -50,22 +145,284 @@ public:
     /// Set the callback function for the TC5 interrupt.
     void setTc5Callback(voidFuncPtr callback);
 
+    /// Set a callback function for the TC4 interrupt that is passed context.
+    void setTc4Callback(contextFuncPtr callback, void* context);
+
+    /// Set a callback function for the TC5 interrupt that is passed context.
+    void setTc5Callback(contextFuncPtr callback, void* context);
+
+    /// Push an event to queue every time TC4 fires, for loop() to handle. NULL stops queueing.
+    void setTc4Queue(ZeroTC45Queue* queue);
+
+    /// Push an event to queue every time TC5 fires, for loop() to handle. NULL stops queueing.
+    void setTc5Queue(ZeroTC45Queue* queue);
+
+    /// Returns the TC4 fire count, overruns, missed overflows and longest callback. The timings need ZEROTC45_STATS.
+    Stats getTc4Stats();
+
+    /// Returns the TC5 fire count, overruns, missed overflows and longest callback. The timings need ZEROTC45_STATS.
+    Stats getTc5Stats();
+
+    /// Set the TC4 statistics to zero.
+    void resetTc4Stats();
+
+    /// Set the TC5 statistics to zero.
+    void resetTc5Stats();
+
+    /// Correct the TC4 periods for a clock error in parts per billion, positive if the clock is fast.
+    void setTc4Correction(int32_t ppb);
+
+    /// Correct the TC5 periods for a clock error in parts per billion, positive if the clock is fast.
+    void setTc5Correction(int32_t ppb);
+
+    /// Returns a count of CPU clocks made from SysTick, which wraps every 2^32 clocks.
+    static uint32_t getCycles();
+
+    /// Call object->Method() from the TC4 interrupt, eg setTc4Callback<Blinker, &Blinker::toggle>(&blinker).
+    template <class T, void (T::*Method)()>
+    void setTc4Callback(T* object) {
+        setTc4Callback(callMethod<T, Method>, object);
+    }
+
+    /// Call object->Method() from the TC5 interrupt.
+    template <class T, void (T::*Method)()>
+    void setTc5Callback(T* object) {
+        setTc5Callback(callMethod<T, Method>, object);
+    }
+
     /// Start TC4 with the given period (seconds), and optionally in one-shot mode
     void startTc4(uint16_t period, boolean oneShot = false);
 
     /// Start TC5 with the given period (seconds), and optionally in one-shot mode
     void startTc5(uint16_t period, boolean oneShot = false);
 
+    /// Start TC4 firing count times, period apart, and then stopping by itself.
+    void startTc4Burst(uint16_t period, uint16_t count);
+
+    /// Start TC5 firing count times, period apart, and then stopping by itself.
+    void startTc5Burst(uint16_t period, uint16_t count);
+
+    /// Returns the number of fires left in the TC4 burst, or 0 if there isn't one.
+    uint16_t getTc4BurstRemaining();
+
+    /// Returns the number of fires left in the TC5 burst, or 0 if there isn't one.
+    uint16_t getTc5BurstRemaining();
+
+    /// Start TC4 and TC5 in phase, with one synchronisation for both instead of one each.
+    void startBoth(uint16_t tc4Period, uint16_t tc5Period, boolean oneShot = false);
+
     /// Stop TC4.
     void stopTc4();
 
     /// Stop TC5.
     void stopTc5();
 
+    /// Start TC4 like startTc4, without waiting for the write that starts it to be synchronised.
+    void startTc4Async(uint16_t period, boolean oneShot = false);
+
+    /// Start TC5 like startTc5, without waiting for the write that starts it to be synchronised.
+    void startTc5Async(uint16_t period, boolean oneShot = false);
+
+    /// Stop TC4 without waiting for the stop command to be synchronised.
+    void stopTc4Async();
+
+    /// Stop TC5 without waiting for the stop command to be synchronised.
+    void stopTc5Async();
+
+    /// Restart the TC4 count from zero using its current configuration.
+    void retriggerTc4();
+
+    /// Restart the TC5 count from zero using its current configuration.
+    void retriggerTc5();
+
+    /// Change the TC4 period without reconfiguring or restarting it.
+    void updatePeriodTc4(uint16_t period);
+
+    /// Change the TC5 period without reconfiguring or restarting it.
+    void updatePeriodTc5(uint16_t period);
+
+    /// Returns true while a TC4 register write is being synchronised.
+    boolean isTc4SyncBusy();
+
+    /// Returns true while a TC5 register write is being synchronised.
+    boolean isTc5SyncBusy();
+
+    /// Start TC4 and TC5 chained as one 32-bit counter with the given period, and optionally in one-shot mode. The TC4 callback is used.
+    void startTc45_32(uint32_t period, boolean oneShot = false);
+
+    /// Stop the chained 32-bit counter and release TC5.
+    void stopTc45_32();
+
+    /// Start TC4 counting freely in tickless mode. The TC4 callback is only called at the deadline given to setTc4Deadline.
+    void startTc4Tickless();
+
+    /// Start TC5 counting freely in tickless mode. The TC5 callback is only called at the deadline given to setTc5Deadline.
+    void startTc5Tickless();
+
+    /// Returns the number of ticks since startTc4Tickless was called.
+    uint32_t getTc4Ticks();
+
+    /// Returns the number of ticks since startTc5Tickless was called.
+    uint32_t getTc5Ticks();
+
+    /// Returns the 64-bit number of ticks since startTc4Tickless was called. Doesn't disable interrupts.
+    uint64_t getTc4Ticks64();
+
+    /// Returns the 64-bit number of ticks since startTc5Tickless was called. Doesn't disable interrupts.
+    uint64_t getTc5Ticks64();
+
+    /// Returns the time since the TC4 period started, in the units of its period, without waiting for the count to synchronise. Returns 0 if TC4 isn't running.
+    uint32_t elapsedTc4();
+
+    /// Returns the time until the TC4 callback is next called, in the units of its period. Returns 0 if TC4 isn't running.
+    uint32_t remainingTc4();
+
+    /// Returns the time since the TC5 period started, in the units of its period, without waiting for the count to synchronise. Returns 0 if TC5 isn't running.
+    uint32_t elapsedTc5();
+
+    /// Returns the time until the TC5 callback is next called, in the units of its period. Returns 0 if TC5 isn't running.
+    uint32_t remainingTc5();
+
+    /// Call the TC4 callback once, when the TC4 tick count reaches deadline.
+    void setTc4Deadline(uint32_t deadline);
+
+    /// Call the TC5 callback once, when the TC5 tick count reaches deadline.
+    void setTc5Deadline(uint32_t deadline);
+
+    /// Cancel the TC4 deadline.
+    void clearTc4Deadline();
+
+    /// Cancel the TC5 deadline.
+    void clearTc5Deadline();
+
+    /// Route a TC4 event to a peripheral, eg EVSYS_ID_USER_ADC_START, through the event system. Returns the channel used or -1.
+    int8_t routeTc4Event(TcEvent event, uint8_t user);
+
+    /// Route a TC5 event to a peripheral, eg EVSYS_ID_USER_ADC_START, through the event system. Returns the channel used or -1.
+    int8_t routeTc5Event(TcEvent event, uint8_t user);
+
+    /// Disconnect an event routed by routeTc4Event.
+    void unrouteTc4Event(int8_t channel);
+
+    /// Disconnect an event routed by routeTc5Event.
+    void unrouteTc5Event(int8_t channel);
+
+    /// Connect any event generator to an event user through a free event system channel. Returns the channel used or -1.
+    static int8_t connectEvent(uint8_t generator, uint8_t user);
+
+    /// Free an event system channel given out by connectEvent.
+    static void disconnectEvent(int8_t channel);
+
+    /// Sleep in the deepest mode the TC clock allows until TC4 or TC5 next fires. Returns the milliseconds slept, or 0 if no timer will fire.
+    uint32_t sleepUntilNextTimer();
+
+    /// Set up the external interrupt of a pin to make an event on each rising edge, or that follows its level for capture. Returns its EVSYS_ID_GEN_ value, or 0 if the pin has no external interrupt.
+    static uint8_t pinEvent(uint8_t pin, boolean level = false);
+
+    /// Set the NVIC priority of the TC4 interrupt, 0 (highest, the default) - 3.
+    void setTc4Priority(uint8_t priority);
+
+    /// Set the NVIC priority of the TC5 interrupt, 0 (highest, the default) - 3.
+    void setTc5Priority(uint8_t priority);
+
+    /// Call the TC4 callback from a lower priority deferred interrupt, leaving only the time critical work in the TC4 interrupt.
+    void setTc4Deferred(boolean deferred);
+
+    /// Call the TC5 callback from a lower priority deferred interrupt, leaving only the time critical work in the TC5 interrupt.
+    void setTc5Deferred(boolean deferred);
+
+    /// Set the NVIC priority of the deferred interrupt, 0 - 3 (lowest, the default).
+    static void setDeferredPriority(uint8_t priority);
+
+    /// The interrupt the deferred callbacks are called from, the PTC touch controller's, which the Arduino core doesn't use.
+    static const IRQn_Type DEFERRED_IRQn = PTC_IRQn;
+
+    /// Make the deferred calls, called by the deferred interrupt handler.
+    static void handleDeferredInterrupt();
+
+    /// Drive a TC4 waveform output pin with PWM, high for duty ticks of each period, or of 65536 ticks if period is 0. Returns false if TC4 can't drive the pin.
+    boolean startTc4Pwm(uint8_t pin, uint16_t duty, uint16_t period = 0);
+
+    /// Drive a TC5 waveform output pin with PWM, high for duty ticks of each period, or of 65536 ticks if period is 0. Returns false if TC5 can't drive the pin.
+    boolean startTc5Pwm(uint8_t pin, uint16_t duty, uint16_t period = 0);
+
+    /// Change the duty cycle of a pin driven by startTc4Pwm without stopping TC4. Safe to call from an interrupt.
+    boolean setTc4Duty(uint8_t pin, uint16_t duty);
+
+    /// Change the duty cycle of a pin driven by startTc5Pwm without stopping TC5. Safe to call from an interrupt.
+    boolean setTc5Duty(uint8_t pin, uint16_t duty);
+
+    /// Measure the period and width of the pulses of an event with TC4 in capture mode. Returns false if there are no free event channels.
+    boolean startTc4Capture(uint8_t generator, CaptureMode mode = CAPTURE_PPW);
+
+    /// Measure the period and width of the pulses of an event with TC5 in capture mode. Returns false if there are no free event channels.
+    boolean startTc5Capture(uint8_t generator, CaptureMode mode = CAPTURE_PPW);
+
+    /// Read the last pulse captured by TC4 in ticks. Returns true if it is new since the last call.
+    boolean readTc4Capture(uint16_t& period, uint16_t& width);
+
+    /// Read the last pulse captured by TC5 in ticks. Returns true if it is new since the last call.
+    boolean readTc5Capture(uint16_t& period, uint16_t& width);
+
+    /// Set up TC4 like startTc4 but hold it stopped until the event from generator starts it. Returns false if there are no free event channels.
+    boolean startTc4OnEvent(uint16_t period, uint8_t generator, boolean oneShot = false);
+
+    /// Set up TC5 like startTc5 but hold it stopped until the event from generator starts it. Returns false if there are no free event channels.
+    boolean startTc5OnEvent(uint16_t period, uint8_t generator, boolean oneShot = false);
+
 private:
-    void configureTC(Tc* tc, uint16_t period, boolean oneShot);
+    // The ZeroTC descriptors, which set up the state of their TC with prepareTC.
+    friend struct ZeroTC45Tc4;
+    friend struct ZeroTC45Tc5;
+
+    // The method is a template argument so the call is direct, with no member function pointer at run time.
+    template <class T, void (T::*Method)()>
+    static void callMethod(void* object) {
+        (static_cast<T*>(object)->*Method)();
+    }
+
+    void configureTC(Tc* tc, uint16_t period, boolean oneShot, boolean wait, boolean hold = false);
+    void configureTC32(uint32_t period, boolean oneShot);
+    void configureBurst(Tc* tc, uint16_t period, uint16_t count);
+    boolean configureOnEvent(Tc* tc, uint16_t period, uint8_t generator, boolean oneShot);
+    boolean configureCapture(Tc* tc, uint8_t generator, CaptureMode mode);
+    boolean configurePwm(Tc* tc, uint8_t pin, uint16_t duty, uint16_t period);
+    void configureTickless(Tc* tc);
     void configureGclk(uint8_t gclkId);
-    
-    Resolution resolution;
+    static void setDeferred(Tc* tc, boolean deferred);
+    boolean changePrescaler(Tc* tc, Resolution resolution);
+    boolean changePrescaler(Tc* tc, ClockConfig config);
+    boolean prepareTC(Tc* tc, ClockConfig config, uint16_t period, boolean oneShot, boolean& interrupt);
+    uint8_t prescaler(Tc* tc);
+    uint32_t timingHz(Tc* tc);
+
+    static constexpr ClockConfig findTickRate(uint32_t hz, ClockSource source, int8_t prescaler) {
+        return (prescaler < 0 || hz == 0)
+                ? ClockConfig { source, 0, 0 }
+             : (sourceHz(source) % ((uint64_t)hz * prescalerDivision(prescaler)) == 0
+                && sourceHz(source) / ((uint64_t)hz * prescalerDivision(prescaler)) >= 1
+                && sourceHz(source) / ((uint64_t)hz * prescalerDivision(prescaler)) <= 255)
+                ? ClockConfig { source, (uint16_t)(sourceHz(source) / ((uint64_t)hz * prescalerDivision(prescaler))), (uint8_t)prescaler }
+             : findTickRate(hz, source, prescaler - 1);
+    }
+
+    ClockConfig clock;              // The TC4 configuration. TC5 shares the source and GCLK divisor.
+    uint8_t tc5Prescaler;
+    uint8_t gclkId;                 // The GCLK given to begin.
+};
+
+/**
+ * The clock configuration for HZ ticks per second from SOURCE, checked at
+ * compile time. For example:
+ *
+ *     timer.begin(ZeroTC45TickRate<100000>::config());   // 10us ticks
+ */
+template <uint32_t HZ, ZeroTC45::ClockSource SOURCE = ZeroTC45::DFLL48M>
+struct ZeroTC45TickRate {
+    static_assert(ZeroTC45::tickRate(HZ, SOURCE).gclkDivisor != 0, "The tick rate can't be made exactly from the clock source");
+
+    static constexpr ZeroTC45::ClockConfig config() {
+        return ZeroTC45::tickRate(HZ, SOURCE);
+    }
 };
 #endif
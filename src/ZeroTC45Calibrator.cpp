@@ -0,0 +1,156 @@
+/*
+  ZeroTC45 library for Arduino Zero and similar.
+
+  Copyright (c) 2020 David Taylor. All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 3.0 of the License, or (at your option) any later version.
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "ZeroTC45Calibrator.h"
+
+// The calibrator measuring an interrupt pin, for the pin interrupt handler.
+static ZeroTC45Calibrator* instance;
+
+/**
+ * Starts measuring. TC5 is started in tickless mode and its ticks are
+ * counted from the first reference edge to the last.
+ *
+ * The resolution is one tick per measurement, so the error of a measurement
+ * over n seconds is about 10^9 / (n * tick rate) ppb, eg 300ppb after 100
+ * seconds of 32kHz ticks. Measure for longer to get closer.
+ *
+ * The reference must run from a different clock to the TC: TCs running from
+ * the crystal can't be measured against an RTC running from the same one.
+ *
+ * @param referenceHz How many times a second referenceEdge is called.
+ */
+void ZeroTC45Calibrator::begin(uint32_t referenceHz) {
+    timer.stopTc5();
+
+    this->referenceHz = referenceHz;
+    tickHz = ZeroTC45::tickHz(timer.getTc5ClockConfig());
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    edges = 0;
+    ticks = 0;
+    __set_PRIMASK(primask);
+
+    timer.setTc5Callback(NULL);
+    timer.startTc5Tickless();
+}
+
+/**
+ * Starts measuring the rising edges of a reference on a pin, which must
+ * have an external interrupt. See begin(uint32_t).
+ *
+ * @param pin The pin the reference is connected to.
+ * @param referenceHz The frequency of the reference, 1 for a PPS.
+ */
+void ZeroTC45Calibrator::begin(uint8_t pin, uint32_t referenceHz) {
+    begin(referenceHz);
+
+    this->pin = pin;
+    instance = this;
+    pinMode(pin, INPUT);
+    attachInterrupt(digitalPinToInterrupt(pin), handleEdge, RISING);
+}
+
+/**
+ * Stops TC5 and the pin interrupt. getErrorPpb and apply still use the
+ * measurement, and TC5 can be used through the ZeroTC45 object again.
+ */
+void ZeroTC45Calibrator::end() {
+    if (pin != NO_PIN) {
+        detachInterrupt(digitalPinToInterrupt(pin));
+        pin = NO_PIN;
+        instance = NULL;
+    }
+
+    timer.stopTc5();
+}
+
+/**
+ * Records an edge of the reference. The first edge starts the measurement.
+ */
+void ZeroTC45Calibrator::referenceEdge() {
+    uint32_t now = timer.getTc5Ticks();
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (edges++ != 0) {
+        ticks += now - lastTick;
+    }
+    lastTick = now;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @return The number of whole reference periods between the first edge and the last.
+ */
+uint32_t ZeroTC45Calibrator::getPeriods() {
+    uint32_t n = edges;
+    return (n == 0) ? 0 : n - 1;
+}
+
+/**
+ * Works out how fast the TC clock is from the ticks that should have been
+ * counted over the measured reference periods and the ticks that were.
+ *
+ * @return The error in parts per billion, positive if the TC clock is fast.
+ */
+int32_t ZeroTC45Calibrator::getErrorPpb() {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t periods = getPeriods();
+    uint64_t counted = ticks;
+    __set_PRIMASK(primask);
+
+    if (periods == 0 || referenceHz == 0) {
+        return 0;
+    }
+
+    // In ticks times referenceHz so it is exact for any reference.
+    int64_t expected = (int64_t)periods * tickHz;
+    int64_t error = (int64_t)(counted * referenceHz) - expected;
+
+    return (error * 1000000000LL + (error >= 0 ? expected / 2 : -expected / 2)) / expected;
+}
+
+/**
+ * Sets the correction of both TC4 and TC5 to the measured error. They share
+ * a GCLK, so they are out by the same amount. Call it after the timers are
+ * configured with begin, which clears the correction.
+ *
+ * @return true if the correction was set, false if no period has been measured yet.
+ */
+boolean ZeroTC45Calibrator::apply() {
+    if (getPeriods() == 0) {
+        return false;
+    }
+
+    int32_t ppb = getErrorPpb();
+    timer.setTc4Correction(ppb);
+    timer.setTc5Correction(ppb);
+    return true;
+}
+
+/**
+ * The interrupt handler for the reference pin.
+ */
+void ZeroTC45Calibrator::handleEdge() {
+    if (instance != NULL) {
+        instance->referenceEdge();
+    }
+}
@@ -0,0 +1,78 @@
+/*
+  ZeroTC45 library for Arduino Zero and similar.
+
+  Copyright (c) 2020 David Taylor. All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 3.0 of the License, or (at your option) any later version.
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef ZERO_TC45_CALIBRATOR_H
+#define ZERO_TC45_CALIBRATOR_H
+
+#include "ZeroTC45.h"
+
+class ZeroTC45Calibrator {
+
+public:
+    /**
+     * Create a calibrator that counts TC5 ticks between the edges of a
+     * reference clock, such as a GPS PPS or an RTCZero alarm, to measure
+     * how fast or slow the TC clock is.
+     *
+     * Only one calibrator should be created per sketch, and TC5 cannot be
+     * used through the ZeroTC45 object while it is measuring.
+     *
+     * @param timer The ZeroTC45 object that owns TC5.
+     */
+    ZeroTC45Calibrator(ZeroTC45& timer) : timer(timer), pin(NO_PIN), edges(0), ticks(0) {};
+
+    /// Start measuring, with referenceEdge called by the sketch referenceHz times a second. ZeroTC45::begin must be called first.
+    void begin(uint32_t referenceHz = 1);
+
+    /// Start measuring the rising edges of a reference on an external interrupt pin, eg a GPS PPS with a referenceHz of 1.
+    void begin(uint8_t pin, uint32_t referenceHz);
+
+    /// Stop measuring and release TC5 and the pin. The measurement is kept.
+    void end();
+
+    /// Record an edge of the reference clock. Call this from the interrupt handler of the reference.
+    void referenceEdge();
+
+    /// Returns the number of reference periods measured so far.
+    uint32_t getPeriods();
+
+    /// Returns how fast the TC clock is in parts per billion, positive if it is fast, or 0 if nothing has been measured.
+    int32_t getErrorPpb();
+
+    /// Correct TC4 and TC5 for the measured error. Returns false if nothing has been measured.
+    boolean apply();
+
+private:
+    static const uint8_t NO_PIN = 0xFF;
+
+    static void handleEdge();
+
+    ZeroTC45& timer;
+
+    uint32_t referenceHz;
+    uint32_t tickHz;
+    uint8_t pin;
+
+    // Counted from the first edge, with the ticks between edges added up so
+    // the 32-bit tick count can wrap during a long measurement.
+    volatile uint32_t edges;
+    volatile uint64_t ticks;
+    uint32_t lastTick;
+};
+#endif
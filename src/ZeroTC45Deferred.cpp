@@ -0,0 +1,81 @@
+/*
+  ZeroTC45 library for Arduino Zero and similar.
+
+  Copyright (c) 2020 David Taylor. All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 3.0 of the License, or (at your option) any later version.
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+// The deferred interrupt of ZeroTC45. Being in a file of its own, its
+// handler is only linked into sketches that call setTc4Deferred or
+// setTc5Deferred, so the PTC vector is free otherwise.
+
+#include "ZeroTC45.h"
+
+static uint8_t deferredPriority = 3;
+
+// Enable the deferred interrupt at its priority, before a timer is set to pend it.
+static void enableDeferredInterrupt() {
+    NVIC_SetPriority(ZeroTC45::DEFERRED_IRQn, deferredPriority);
+    NVIC_EnableIRQ(ZeroTC45::DEFERRED_IRQn);
+}
+
+/**
+ * Split the TC4 interrupt in two. The TC interrupt, at the TC4 priority,
+ * does only the time critical work: it clears the flag, corrects the
+ * period, counts the fire and pushes the event to the queue, if there is
+ * one, with its timestamp. It then pends the deferred interrupt, at the
+ * lower priority given to setDeferredPriority, which calls the callback.
+ *
+ * If the deferred interrupt falls 255 fires behind, the fires after that are
+ * counted as missed. The Stats callback times are those of the deferred calls.
+ *
+ * The deferred interrupt uses the PTC interrupt vector, so the touch
+ * controller can't be used with interrupts at the same time.
+ *
+ * @param deferred If true call the callback from the deferred interrupt, otherwise from the TC interrupt.
+ */
+void ZeroTC45::setTc4Deferred(boolean deferred) {
+    if (deferred) {
+        enableDeferredInterrupt();
+    }
+    setDeferred(TC4, deferred);
+}
+
+/**
+ * Split the TC5 interrupt in two. See setTc4Deferred.
+ *
+ * @param deferred If true call the callback from the deferred interrupt, otherwise from the TC interrupt.
+ */
+void ZeroTC45::setTc5Deferred(boolean deferred) {
+    if (deferred) {
+        enableDeferredInterrupt();
+    }
+    setDeferred(TC5, deferred);
+}
+
+/**
+ * Set the NVIC priority of the deferred interrupt that calls the callbacks
+ * given to setTc4Deferred and setTc5Deferred. The default is 3, the lowest.
+ *
+ * @param priority 0 (highest) - 3 (lowest). It should be lower than the TC priorities.
+ */
+void ZeroTC45::setDeferredPriority(uint8_t priority) {
+    deferredPriority = (priority > 3) ? 3 : priority;
+    NVIC_SetPriority(DEFERRED_IRQn, deferredPriority);
+}
+
+void PTC_Handler() {
+    ZeroTC45::handleDeferredInterrupt();
+}
@@ -0,0 +1,213 @@
+/*
+  ZeroTC45 library for Arduino Zero and similar.
+
+  Copyright (c) 2020 David Taylor. All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 3.0 of the License, or (at your option) any later version.
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+
+#include "ZeroTC45Dma.h"
+
+// The DMAC reads the first descriptor of each channel from here, and writes
+// the state of a suspended or running channel back to the write-back table.
+// Both tables must be 128-bit aligned.
+__attribute__((__aligned__(16))) static DmacDescriptor descriptors[DMAC_CH_NUM];
+__attribute__((__aligned__(16))) static DmacDescriptor writeBack[DMAC_CH_NUM];
+
+// The descriptor table the DMAC uses, which is another user's if the DMAC was already enabled.
+static DmacDescriptor* base = descriptors;
+
+static ZeroTC45Dma::ChannelCallback callbacks[DMAC_CH_NUM];
+static uint16_t usedChannels;
+static boolean started;
+
+/**
+ * Enable the DMAC clocks and point the DMAC at the library descriptor
+ * tables, with all priority levels enabled. Later calls do nothing.
+ *
+ * If the DMAC is already enabled, eg by the Arduino core or another
+ * library, it is left as it is and its descriptor table is used, so the
+ * other user's channels keep running. The base addresses can only be
+ * changed by disabling or resetting the DMAC, which would stop them.
+ */
+void ZeroTC45Dma::begin() {
+    if (started) {
+        return;
+    }
+
+    PM->AHBMASK.reg |= PM_AHBMASK_DMAC;
+    PM->APBBMASK.reg |= PM_APBBMASK_DMAC;
+
+    if (DMAC->CTRL.bit.DMAENABLE && DMAC->BASEADDR.reg != 0) {
+        base = (DmacDescriptor*)(uintptr_t)DMAC->BASEADDR.reg;
+
+        // The channels use priority level 0. LVLEN can be written while the DMAC is enabled.
+        DMAC->CTRL.reg |= DMAC_CTRL_LVLEN(1);
+    } else {
+        // The base addresses can only be written while the DMAC is disabled. The static tables start zeroed.
+        DMAC->CTRL.reg = 0;
+        while (DMAC->CTRL.bit.DMAENABLE);
+
+        base = descriptors;
+        DMAC->BASEADDR.reg = (uint32_t)descriptors;
+        DMAC->WRBADDR.reg = (uint32_t)writeBack;
+
+        DMAC->CTRL.reg = DMAC_CTRL_DMAENABLE | DMAC_CTRL_LVLEN(0xF);
+    }
+
+    NVIC_ClearPendingIRQ(DMAC_IRQn);
+    NVIC_EnableIRQ(DMAC_IRQn);
+    NVIC_SetPriority(DMAC_IRQn, 0x00);
+
+    started = true;
+}
+
+/**
+ * Returns true if a channel looks to be in use by another DMA user: it is
+ * enabled, or its first descriptor has been set up.
+ */
+static boolean usedElsewhere(uint8_t channel) {
+    DMAC->CHID.reg = channel;
+    return DMAC->CHCTRLA.bit.ENABLE || (base[channel].BTCTRL.reg & DMAC_BTCTRL_VALID);
+}
+
+/**
+ * Reserve a free DMA channel, from the lowest up. Channels used by another
+ * DMA user that set the DMAC up first are skipped.
+ *
+ * @return The channel, or -1 if all channels are in use.
+ */
+int8_t ZeroTC45Dma::allocate() {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    int8_t channel = 0;
+    while (channel < DMAC_CH_NUM && ((usedChannels & (1 << channel)) || usedElsewhere(channel))) {
+        channel++;
+    }
+
+    if (channel < DMAC_CH_NUM) {
+        usedChannels |= 1 << channel;
+    } else {
+        channel = -1;
+    }
+
+    __set_PRIMASK(primask);
+    return channel;
+}
+
+/**
+ * Disable a channel given out by allocate, and free it.
+ *
+ * @param channel The channel returned by allocate.
+ */
+void ZeroTC45Dma::release(int8_t channel) {
+    if (channel < 0 || channel >= DMAC_CH_NUM) {
+        return;
+    }
+
+    stop(channel);
+    callbacks[channel] = NULL;
+
+    // So allocate doesn't take the channel for another user's.
+    base[channel].BTCTRL.reg = 0;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    usedChannels &= ~(1 << channel);
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @param channel The DMA channel.
+ * @return The descriptor the channel starts with. Further descriptors are linked from its DESCADDR.
+ */
+DmacDescriptor* ZeroTC45Dma::descriptor(uint8_t channel) {
+    return &base[channel];
+}
+
+/**
+ * Set the function called from the DMAC interrupt handler for a channel.
+ *
+ * @param channel The DMA channel.
+ * @param callback The function to call, or NULL for none.
+ */
+void ZeroTC45Dma::setCallback(uint8_t channel, ChannelCallback callback) {
+    callbacks[channel] = callback;
+}
+
+/**
+ * Reset a channel, set its trigger and enable it. The descriptor must be
+ * set up first. The block transfer complete and transfer error interrupts
+ * are enabled; a descriptor only raises the block interrupt if its
+ * BTCTRL.BLOCKACT asks for it.
+ *
+ * The DMAC registers are not synchronised.
+ *
+ * @param channel The DMA channel.
+ * @param triggerSource The peripheral DMAC_ID_ trigger, eg ADC_DMAC_ID_RESRDY.
+ * @param triggerAction The DMAC_CHCTRLB_TRIGACT_ value, eg DMAC_CHCTRLB_TRIGACT_BEAT.
+ */
+void ZeroTC45Dma::start(uint8_t channel, uint8_t triggerSource, uint32_t triggerAction) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    // The channel registers are selected by CHID, so nothing else can use them until this is done.
+    DMAC->CHID.reg = channel;
+    DMAC->CHCTRLA.reg = 0;
+    while (DMAC->CHCTRLA.bit.ENABLE);
+    DMAC->CHCTRLA.reg = DMAC_CHCTRLA_SWRST;
+    while (DMAC->CHCTRLA.bit.SWRST);
+    DMAC->CHCTRLB.reg = DMAC_CHCTRLB_LVL(0)
+                      | DMAC_CHCTRLB_TRIGSRC(triggerSource)
+                      | triggerAction;
+    DMAC->CHINTENSET.reg = DMAC_CHINTENSET_TCMPL | DMAC_CHINTENSET_TERR;
+    DMAC->CHCTRLA.reg = DMAC_CHCTRLA_ENABLE;
+
+    __set_PRIMASK(primask);
+}
+
+/**
+ * Disable a channel. A beat in progress is finished first.
+ *
+ * @param channel The DMA channel.
+ */
+void ZeroTC45Dma::stop(uint8_t channel) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    DMAC->CHID.reg = channel;
+    DMAC->CHCTRLA.reg = 0;
+    while (DMAC->CHCTRLA.bit.ENABLE);
+    DMAC->CHINTENCLR.reg = DMAC_CHINTENCLR_TCMPL | DMAC_CHINTENCLR_TERR;
+    DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_TCMPL | DMAC_CHINTFLAG_TERR;
+
+    __set_PRIMASK(primask);
+}
+
+void DMAC_Handler() {
+    // Service every channel with a pending interrupt, lowest first.
+    while (DMAC->INTSTATUS.reg) {
+        uint8_t channel = DMAC->INTPEND.reg & DMAC_INTPEND_ID_Msk;
+
+        DMAC->CHID.reg = channel;
+        uint8_t flags = DMAC->CHINTFLAG.reg;
+        DMAC->CHINTFLAG.reg = flags;
+
+        if (callbacks[channel] != NULL) {
+            callbacks[channel](channel, flags);
+        }
+    }
+}
@@ -0,0 +1,63 @@
+/*
+  ZeroTC45 library for Arduino Zero and similar.
+
+  Copyright (c) 2020 David Taylor. All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 3.0 of the License, or (at your option) any later version.
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+
+#ifndef ZERO_TC45_DMA_H
+#define ZERO_TC45_DMA_H
+
+#include "Arduino.h"
+
+/**
+ * A minimal owner of the DMAC for the ZeroTC45 modules that move data
+ * without the CPU. It holds the descriptor tables and dispatches the DMAC
+ * interrupt to a callback per channel.
+ *
+ * It defines DMAC_Handler, which is only linked into sketches that use
+ * ZeroTC45Dma, eg through ZeroTC45Sampler. It can't
+ * be used together with another DMA library that defines it too. A DMAC
+ * that is already enabled is shared rather than reset.
+ */
+class ZeroTC45Dma {
+
+public:
+    /// Called from the DMAC interrupt handler with the channel and its CHINTFLAG flags.
+    typedef void(*ChannelCallback)(uint8_t channel, uint8_t flags);
+
+    /// Enable the DMAC with the library descriptor tables, or share it if it is already enabled. It is safe to call this more than once.
+    static void begin();
+
+    /// Reserve a free DMA channel. Returns the channel or -1 if all are in use.
+    static int8_t allocate();
+
+    /// Disable a DMA channel and make it free again.
+    static void release(int8_t channel);
+
+    /// Returns the first descriptor of a channel, which is set up before the channel is enabled.
+    static DmacDescriptor* descriptor(uint8_t channel);
+
+    /// Set the callback for the block transfer complete and error interrupts of a channel.
+    static void setCallback(uint8_t channel, ChannelCallback callback);
+
+    /// Set up a channel with a trigger source and enable it, with the interrupts enabled.
+    static void start(uint8_t channel, uint8_t triggerSource, uint32_t triggerAction);
+
+    /// Disable a channel.
+    static void stop(uint8_t channel);
+};
+#endif
@@ -0,0 +1,49 @@
+/*
+  ZeroTC45 library for Arduino Zero and similar.
+
+  Copyright (c) 2020 David Taylor. All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 3.0 of the License, or (at your option) any later version.
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef ZERO_TC45_HAL_H
+#define ZERO_TC45_HAL_H
+
+/*
+  The little the scheduling code needs from the platform, so it can be built
+  for the SAMD21 with the Arduino core or on a host computer against the
+  simulated timer in ZeroTC45Sim.h.
+*/
+
+#if defined(ARDUINO_ARCH_SAMD)
+
+#include "Arduino.h"
+
+#else
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef bool boolean;
+
+// On the host nothing runs at interrupt level, so there is nothing to mask.
+static inline uint32_t __get_PRIMASK() { return 0; }
+static inline void __disable_irq() {}
+static inline void __set_PRIMASK(uint32_t) {}
+
+#endif
+
+typedef void(*voidFuncPtr)(void);
+
+#endif
@@ -0,0 +1,103 @@
+/*
+  ZeroTC45 library for Arduino Zero and similar.
+
+  Copyright (c) 2020 David Taylor. All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 3.0 of the License, or (at your option) any later version.
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+
+#include "ZeroTC45Histogram.h"
+
+// The width of the longest bar printed.
+static const uint8_t BAR_WIDTH = 40;
+
+void ZeroTC45Histogram::clear() {
+    memset(bins, 0, sizeof(bins));
+    total = 0;
+    sum = 0;
+    minimum = INT32_MAX;
+    maximum = INT32_MIN;
+}
+
+/**
+ * Add a value to the histogram.
+ *
+ * @param value The value to add.
+ */
+void ZeroTC45Histogram::add(int32_t value) {
+    int32_t bin = (value < low) ? 0 : (int32_t)((uint32_t)(value - low) / binWidth);
+    if (bin >= BINS) {
+        bin = BINS - 1;
+    }
+
+    bins[bin]++;
+    total++;
+    sum += value;
+
+    if (value < minimum) {
+        minimum = value;
+    }
+
+    if (value > maximum) {
+        maximum = value;
+    }
+}
+
+/**
+ * Print the count, minimum, mean and maximum, and then one line per bin
+ * with its range, count and a bar scaled to the largest bin.
+ *
+ * @param out Where to print, eg Serial.
+ * @param title A line printed first.
+ * @param unit The unit of the values, eg "clocks".
+ */
+void ZeroTC45Histogram::print(Print& out, const char* title, const char* unit) {
+    char line[80];
+
+    out.println(title);
+
+    if (total == 0) {
+        out.println("  no values");
+        return;
+    }
+
+    snprintf(line, sizeof(line), "  count %lu, min %ld, mean %ld, max %ld %s",
+             (unsigned long)total, (long)minimum, (long)(sum / (int64_t)total), (long)maximum, unit);
+    out.println(line);
+
+    uint32_t largest = 1;
+    for (uint8_t i = 0; i < BINS; i++) {
+        if (bins[i] > largest) {
+            largest = bins[i];
+        }
+    }
+
+    for (uint8_t i = 0; i < BINS; i++) {
+        int32_t from = low + (int32_t)(i * binWidth);
+
+        // The first and last bins also hold the values out of range.
+        const char* prefix = (i == 0) ? "<=" : (i == BINS - 1) ? ">=" : "  ";
+        int32_t shown = (i == 0) ? from + (int32_t)binWidth - 1 : from;
+
+        uint8_t bar = (uint8_t)(((uint64_t)bins[i] * BAR_WIDTH + largest - 1) / largest);
+        int n = snprintf(line, sizeof(line), "  %s%8ld %8lu ", prefix, (long)shown, (unsigned long)bins[i]);
+        for (uint8_t b = 0; b < bar && n < (int)sizeof(line) - 1; b++) {
+            line[n++] = '#';
+        }
+        line[n] = '\0';
+
+        out.println(line);
+    }
+}
@@ -0,0 +1,61 @@
+/*
+  ZeroTC45 library for Arduino Zero and similar.
+
+  Copyright (c) 2020 David Taylor. All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 3.0 of the License, or (at your option) any later version.
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+
+#ifndef ZERO_TC45_HISTOGRAM_H
+#define ZERO_TC45_HISTOGRAM_H
+
+#include "Arduino.h"
+
+/**
+ * A fixed size histogram for the benchmark examples. Values below the first
+ * bin or above the last are counted in the first or last bin, and the
+ * minimum, maximum and mean are kept exactly.
+ */
+class ZeroTC45Histogram {
+
+public:
+    /// The number of bins.
+    static const uint8_t BINS = 16;
+
+    /// Create a histogram whose first bin starts at low, with bins binWidth wide.
+    ZeroTC45Histogram(int32_t low, uint32_t binWidth) : low(low), binWidth(binWidth ? binWidth : 1) { clear(); };
+
+    /// Remove all values.
+    void clear();
+
+    /// Add a value. This is cheap enough to call from an interrupt handler.
+    void add(int32_t value);
+
+    /// Returns the number of values added.
+    uint32_t count() { return total; };
+
+    /// Print the statistics and a bar for each bin to out.
+    void print(Print& out, const char* title, const char* unit);
+
+private:
+    int32_t low;
+    uint32_t binWidth;
+    uint32_t bins[BINS];
+    uint32_t total;
+    int64_t sum;
+    int32_t minimum;
+    int32_t maximum;
+};
+#endif
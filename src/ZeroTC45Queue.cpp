@@ -0,0 +1,107 @@
+/*
+  ZeroTC45 library for Arduino Zero and similar.
+
+  Copyright (c) 2020 David Taylor. All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 3.0 of the License, or (at your option) any later version.
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+
+#include "ZeroTC45Queue.h"
+
+// The head and tail indices run freely and wrap at 256, so head - tail is
+// the number of events waiting even after they wrap. Each index is only
+// written by one side, and a single byte write is atomic, so no locking is
+// needed. The event is written before head is moved past it, and read
+// before tail is moved past it. The events aren't volatile, so a __DMB()
+// (a memory barrier for the compiler as well as the CPU) between the event
+// and the index keeps the compiler from reordering them.
+
+/**
+ * Add an event to the queue. This is called by the interrupt handler.
+ *
+ * @param event The event to add.
+ * @return true if the event was added, false if the queue was full and the event was dropped.
+ */
+boolean ZeroTC45Queue::push(const ZeroTC45Event& event) {
+    uint8_t h = head;
+    if ((uint8_t)(h - tail) > mask) {
+        drops++;
+        return false;
+    }
+
+    events[h & mask] = event;
+    __DMB();
+    head = h + 1;
+    return true;
+}
+
+/**
+ * Remove the oldest event from the queue.
+ *
+ * @param event Set to the event removed.
+ * @return true if an event was removed, false if the queue was empty.
+ */
+boolean ZeroTC45Queue::pop(ZeroTC45Event& event) {
+    uint8_t t = tail;
+    if (t == head) {
+        return false;
+    }
+
+    __DMB();
+    event = events[t & mask];
+    __DMB();
+    tail = t + 1;
+    return true;
+}
+
+/**
+ * Remove a batch of events from the queue, oldest first. Only the events
+ * waiting when this is called are removed, so a busy timer can't keep it
+ * from returning.
+ *
+ * @param events The array to copy the events into.
+ * @param max The size of the array.
+ * @return The number of events removed.
+ */
+uint8_t ZeroTC45Queue::drain(ZeroTC45Event* events, uint8_t max) {
+    uint8_t t = tail;
+    uint8_t count = head - t;
+    if (count > max) {
+        count = max;
+    }
+
+    __DMB();
+    for (uint8_t i = 0; i < count; i++) {
+        events[i] = this->events[(uint8_t)(t + i) & mask];
+    }
+    __DMB();
+
+    tail = t + count;
+    return count;
+}
+
+/**
+ * @return The number of events waiting in the queue.
+ */
+uint8_t ZeroTC45Queue::available() {
+    return head - tail;
+}
+
+/**
+ * @return The number of events dropped because the queue was full, since the queue was created.
+ */
+uint32_t ZeroTC45Queue::dropped() {
+    return drops;
+}
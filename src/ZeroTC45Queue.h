@@ -0,0 +1,86 @@
+/*
+  ZeroTC45 library for Arduino Zero and similar.
+
+  Copyright (c) 2020 David Taylor. All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 3.0 of the License, or (at your option) any later version.
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+
+#ifndef ZERO_TC45_QUEUE_H
+#define ZERO_TC45_QUEUE_H
+
+#include "Arduino.h"
+
+/// A record of one timer interrupt, pushed by the interrupt handler.
+struct ZeroTC45Event {
+    uint8_t timer;          // 4 for TC4 (and the 32-bit counter), 5 for TC5.
+    uint32_t count;         // The number of times the timer has fired, starting from 1. A gap means records were dropped.
+    uint32_t micros;        // micros() when the interrupt was handled, or 0 unless the library is built with ZEROTC45_STATS.
+};
+
+/**
+ * A fixed size single-producer, single-consumer queue of timer events. The
+ * timer interrupt handlers push to it and loop() pops from it, with no
+ * locking and no allocation. Create a ZeroTC45EventQueue of the size needed.
+ *
+ * TC4 and TC5 can share a queue while their interrupts have the same
+ * priority, as then neither handler can interrupt the other.
+ */
+class ZeroTC45Queue {
+
+public:
+    /// Add an event. Called from the interrupt handler. Returns false and counts a drop if the queue is full.
+    boolean push(const ZeroTC45Event& event);
+
+    /// Remove the oldest event. Returns false if the queue is empty.
+    boolean pop(ZeroTC45Event& event);
+
+    /// Remove up to max events into events, oldest first. Returns the number removed.
+    uint8_t drain(ZeroTC45Event* events, uint8_t max);
+
+    /// Returns the number of events waiting.
+    uint8_t available();
+
+    /// Returns the number of events dropped because the queue was full.
+    uint32_t dropped();
+
+protected:
+    ZeroTC45Queue(ZeroTC45Event* events, uint8_t mask) : events(events), mask(mask), head(0), tail(0), drops(0) {};
+
+private:
+    ZeroTC45Event* events;
+    uint8_t mask;                   // The size minus 1. The size is a power of 2.
+    volatile uint8_t head;          // Free running index of the next push, only written by the producer.
+    volatile uint8_t tail;          // Free running index of the next pop, only written by the consumer.
+    volatile uint32_t drops;
+};
+
+/**
+ * A ZeroTC45Queue with room for SIZE events. SIZE must be a power of 2, up to 128.
+ *
+ *     static ZeroTC45EventQueue<16> queue;
+ *     timer.setTc4Queue(&queue);
+ */
+template <uint8_t SIZE>
+class ZeroTC45EventQueue : public ZeroTC45Queue {
+    static_assert(SIZE >= 2 && SIZE <= 128 && (SIZE & (SIZE - 1)) == 0, "The queue size must be a power of 2 from 2 to 128");
+
+public:
+    ZeroTC45EventQueue() : ZeroTC45Queue(storage, SIZE - 1) {};
+
+private:
+    ZeroTC45Event storage[SIZE];
+};
+#endif
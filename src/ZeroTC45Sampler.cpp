@@ -0,0 +1,179 @@
+/*
+  ZeroTC45 library for Arduino Zero and similar.
+
+  Copyright (c) 2020 David Taylor. All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 3.0 of the License, or (at your option) any later version.
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+
+#include "ZeroTC45Sampler.h"
+
+// The sampler that owns the DMA channel, for the DMA callback.
+static ZeroTC45Sampler* instance;
+
+// The descriptor for the second half of the buffer. The first is in the DMAC descriptor table.
+__attribute__((__aligned__(16))) static DmacDescriptor secondDescriptor;
+
+/**
+ * Set up the ADC and a DMA channel to sample a pin into a double buffer.
+ *
+ * The ADC is configured by a call to analogRead, so analogReference and
+ * analogReadResolution apply, and then set to start a conversion on each
+ * event. The DMAC copies each result into the buffer, filling the first
+ * half and then the second half over and over again. The callback is
+ * called from the DMAC interrupt when each half is full, so there is
+ * one interrupt per block of samples instead of one per sample.
+ *
+ * @param pin The analog pin to sample, eg A0.
+ * @param buffer The buffer for the samples. It must stay valid until end is called.
+ * @param length The number of samples in the buffer, an even number of at least 2.
+ * @param callback The function to call with each block of length / 2 samples.
+ * @return false if the arguments are not valid or there is no DMA or event channel free.
+ */
+boolean ZeroTC45Sampler::begin(uint8_t pin, volatile uint16_t* buffer, uint16_t length, BlockCallback callback) {
+    if (buffer == NULL || length < 2 || (length & 1) || callback == NULL) {
+        return false;
+    }
+
+    end();
+
+    ZeroTC45Dma::begin();
+    dmaChannel = ZeroTC45Dma::allocate();
+    if (dmaChannel < 0) {
+        return false;
+    }
+
+    eventChannel = timer.routeTc5Event(ZeroTC45::OVERFLOW_EVENT, EVSYS_ID_USER_ADC_START);
+    if (eventChannel < 0) {
+        ZeroTC45Dma::release(dmaChannel);
+        dmaChannel = -1;
+        return false;
+    }
+
+    this->buffer = buffer;
+    this->blockLength = length / 2;
+    this->callback = callback;
+    instance = this;
+
+    // Let the Arduino core set up the pin, the ADC clock, reference and input.
+    analogRead(pin);
+
+    // The core disables the ADC after each analogRead.
+    ADC->EVCTRL.reg = ADC_EVCTRL_STARTEI;
+    ADC->CTRLA.bit.ENABLE = 1;
+    while (ADC->STATUS.bit.SYNCBUSY);
+
+    ZeroTC45Dma::setCallback(dmaChannel, handleDma);
+
+    // The sampler triggers the ADC through the event system so TC5 needs no interrupt.
+    timer.setTc5Callback(NULL);
+
+    return true;
+}
+
+/**
+ * Stop sampling and free TC5, the DMA channel and the event channel. The
+ * ADC is disabled so analogRead can be used again.
+ */
+void ZeroTC45Sampler::end() {
+    if (dmaChannel < 0) {
+        return;
+    }
+
+    stop();
+
+    timer.unrouteTc5Event(eventChannel);
+    eventChannel = -1;
+
+    ZeroTC45Dma::release(dmaChannel);
+    dmaChannel = -1;
+
+    ADC->EVCTRL.reg = 0;
+    ADC->CTRLA.bit.ENABLE = 0;
+    while (ADC->STATUS.bit.SYNCBUSY);
+
+    instance = NULL;
+}
+
+/**
+ * Start sampling, with a conversion every period ticks of TC5. The first
+ * block is written to the start of the buffer.
+ *
+ * @param period The time between samples, in ticks of the TC5 resolution given to ZeroTC45::begin.
+ */
+void ZeroTC45Sampler::start(uint16_t period) {
+    if (dmaChannel < 0) {
+        return;
+    }
+
+    timer.stopTc5();
+    ZeroTC45Dma::stop(dmaChannel);
+
+    // Two descriptors linked in a loop, each raising the block interrupt when its half is full.
+    DmacDescriptor* first = ZeroTC45Dma::descriptor(dmaChannel);
+    setDescriptor(*first, buffer, &secondDescriptor);
+    setDescriptor(secondDescriptor, buffer + blockLength, first);
+    secondBlock = false;
+
+    // Discard a result left from before, so the first beat is the first sample.
+    ADC->INTFLAG.reg = ADC_INTFLAG_RESRDY;
+
+    // One beat, one sample, every time a result is ready.
+    ZeroTC45Dma::start(dmaChannel, ADC_DMAC_ID_RESRDY, DMAC_CHCTRLB_TRIGACT_BEAT);
+
+    timer.startTc5(period);
+}
+
+/**
+ * Stop sampling. TC5 is stopped, so there are no more conversions, and the DMA channel is disabled.
+ */
+void ZeroTC45Sampler::stop() {
+    if (dmaChannel < 0) {
+        return;
+    }
+
+    timer.stopTc5();
+    ZeroTC45Dma::stop(dmaChannel);
+}
+
+/**
+ * The DMA callback, called when a half of the buffer is full.
+ */
+void ZeroTC45Sampler::handleDma(uint8_t channel, uint8_t flags) {
+    if (instance == NULL || ! (flags & DMAC_CHINTFLAG_TCMPL)) {
+        return;
+    }
+
+    volatile uint16_t* block = instance->secondBlock ? instance->buffer + instance->blockLength : instance->buffer;
+    instance->secondBlock = ! instance->secondBlock;
+
+    instance->callback(block, instance->blockLength);
+}
+
+/**
+ * Set up a descriptor that moves blockLength ADC results into block, one
+ * half-word beat per result, and then continues with next.
+ */
+void ZeroTC45Sampler::setDescriptor(DmacDescriptor& descriptor, volatile uint16_t* block, DmacDescriptor* next) {
+    descriptor.BTCTRL.reg = DMAC_BTCTRL_VALID
+                          | DMAC_BTCTRL_BLOCKACT_INT        // Raise the block interrupt and carry on with the next descriptor.
+                          | DMAC_BTCTRL_BEATSIZE_HWORD
+                          | DMAC_BTCTRL_DSTINC;             // The source, ADC RESULT, stays the same.
+    descriptor.BTCNT.reg = blockLength;
+    descriptor.SRCADDR.reg = (uint32_t)&ADC->RESULT.reg;
+    // With DSTINC the destination address is the end of the block.
+    descriptor.DSTADDR.reg = (uint32_t)(block + blockLength);
+    descriptor.DESCADDR.reg = (uint32_t)next;
+}
@@ -0,0 +1,70 @@
+/*
+  ZeroTC45 library for Arduino Zero and similar.
+
+  Copyright (c) 2020 David Taylor. All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 3.0 of the License, or (at your option) any later version.
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+
+#ifndef ZERO_TC45_SAMPLER_H
+#define ZERO_TC45_SAMPLER_H
+
+#include "ZeroTC45.h"
+#include "ZeroTC45Dma.h"
+
+class ZeroTC45Sampler {
+
+public:
+    /// Called with a block of samples that has just been filled. The block is not written again until the other half of the buffer is full.
+    typedef void(*BlockCallback)(const volatile uint16_t* samples, uint16_t count);
+
+    /**
+     * Create a sampler that starts ADC conversions from TC5 through the
+     * event system and moves the results into a buffer with the DMAC.
+     *
+     * Only one sampler should be created per sketch, and TC5 cannot be used
+     * through the ZeroTC45 object while the sampler is running.
+     *
+     * @param timer The ZeroTC45 object that owns TC5.
+     */
+    ZeroTC45Sampler(ZeroTC45& timer) : timer(timer), dmaChannel(-1), eventChannel(-1) {};
+
+    /// Set up the ADC to sample pin into a double buffer of length samples. ZeroTC45::begin must be called first. Returns false if there is no DMA or event channel free.
+    boolean begin(uint8_t pin, volatile uint16_t* buffer, uint16_t length, BlockCallback callback);
+
+    /// Stop sampling and release TC5, the DMA channel and the event channel.
+    void end();
+
+    /// Start sampling every period TC5 ticks.
+    void start(uint16_t period);
+
+    /// Stop sampling. The half-filled block is discarded.
+    void stop();
+
+private:
+    static void handleDma(uint8_t channel, uint8_t flags);
+
+    void setDescriptor(DmacDescriptor& descriptor, volatile uint16_t* block, DmacDescriptor* next);
+
+    ZeroTC45& timer;
+
+    volatile uint16_t* buffer;
+    uint16_t blockLength;
+    BlockCallback callback;
+    int8_t dmaChannel;
+    int8_t eventChannel;
+    volatile boolean secondBlock;   // True while the DMAC is filling the second half of the buffer.
+};
+#endif
@@ -0,0 +1,417 @@
+/*
+  ZeroTC45 library for Arduino Zero and similar.
+
+  Copyright (c) 2020 David Taylor. All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 3.0 of the License, or (at your option) any later version.
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef ZERO_TC45_SCHEDULER_H
+#define ZERO_TC45_SCHEDULER_H
+
+#include "ZeroTC45Hal.h"
+
+/// The number of virtual timers available. Define this before including the header to change it.
+#ifndef ZEROTC45_SCHEDULER_MAX_TIMERS
+#define ZEROTC45_SCHEDULER_MAX_TIMERS 48
+#endif
+
+#if ZEROTC45_SCHEDULER_MAX_TIMERS > 127
+#error "ZEROTC45_SCHEDULER_MAX_TIMERS must not be more than 127"
+#endif
+
+/**
+ * A scheduler of virtual timers on the TC4 tickless API of Backend, which is
+ * ZeroTC45 on the board, as ZeroTC45Scheduler, or ZeroTC45Sim to run the same
+ * scheduling code against virtual time, eg on a host computer.
+ */
+template <class Backend>
+class ZeroTC45BasicScheduler {
+
+public:
+    /// Identifies a virtual timer. Negative values are not valid timers.
+    typedef int8_t TimerId;
+
+    /// Returned by startTimer when no timer could be started.
+    static const TimerId INVALID_TIMER = -1;
+
+    /// The number of virtual timers in the pool.
+    static const uint8_t MAX_TIMERS = ZEROTC45_SCHEDULER_MAX_TIMERS;
+
+    /**
+     * Create a scheduler that multiplexes virtual timers onto TC4.
+     *
+     * Only one scheduler should be created per sketch, and TC4 cannot be
+     * used through the ZeroTC45 object while the scheduler is running.
+     *
+     * @param timer The ZeroTC45 object that owns TC4, or a ZeroTC45Sim.
+     */
+    ZeroTC45BasicScheduler(Backend& timer) : timer(timer), heapSize(0), freeCount(0), expiring(false) {
+        clearSlots();
+    };
+
+    /// Take over TC4 and start the scheduler. ZeroTC45::begin must be called first.
+    void begin();
+
+    /// Stop all virtual timers and release TC4.
+    void end();
+
+    /// Start a virtual timer that calls callback after period ticks, and every period ticks after that unless oneShot is true.
+    TimerId startTimer(uint32_t period, voidFuncPtr callback, boolean oneShot = false);
+
+    /// Stop a virtual timer. Returns false if the timer was not running.
+    boolean stopTimer(TimerId id);
+
+    /// Returns true if the virtual timer is running.
+    boolean isRunning(TimerId id);
+
+    /// Returns the current scheduler time in ticks of the ZeroTC45 resolution.
+    uint32_t now();
+
+private:
+    struct Timer {
+        uint32_t deadline;
+        uint32_t period;            // Zero for one-shot timers.
+        voidFuncPtr callback;
+        uint8_t heapIndex;          // NOT_QUEUED when the timer slot is free.
+    };
+
+    static const uint8_t NOT_QUEUED = 0xFF;
+
+    static void handleDeadline();
+
+    void clearSlots();
+    void arm();
+    void runExpired();
+    void insert(uint8_t slot);
+    void remove(uint8_t heapIndex);
+    void siftUp(uint8_t heapIndex);
+    void siftDown(uint8_t heapIndex);
+    void place(uint8_t heapIndex, uint8_t slot);
+    boolean before(uint8_t slotA, uint8_t slotB);
+
+    // The scheduler that owns TC4, for the TC4 callback.
+    static ZeroTC45BasicScheduler* instance;
+
+    Backend& timer;
+
+    Timer timers[MAX_TIMERS];
+    uint8_t heap[MAX_TIMERS];       // Slot numbers, ordered as a binary min-heap on deadline.
+    uint8_t heapSize;
+    uint8_t freeSlots[MAX_TIMERS];  // Stack of unused slot numbers.
+    uint8_t freeCount;
+    boolean expiring;               // True while runExpired calls callbacks, which handleDeadline arms after.
+};
+
+template <class Backend> ZeroTC45BasicScheduler<Backend>* ZeroTC45BasicScheduler<Backend>::instance = NULL;
+
+/**
+ * Starts the scheduler. TC4 is started in tickless mode and its deadline is
+ * set to the deadline of the earliest virtual timer, so there is only an
+ * interrupt when a timer expires.
+ *
+ * The scheduler time is the TC4 tick count, in ticks of the resolution given to ZeroTC45::begin.
+ *
+ * Any virtual timers that were running are discarded.
+ */
+template <class Backend>
+void ZeroTC45BasicScheduler<Backend>::begin() {
+    timer.stopTc4();
+
+    clearSlots();
+    freeCount = MAX_TIMERS;
+    for (uint8_t i = 0; i < MAX_TIMERS; i++) {
+        freeSlots[i] = MAX_TIMERS - 1 - i;
+    }
+
+    instance = this;
+    timer.setTc4Callback(handleDeadline);
+    timer.startTc4Tickless();
+}
+
+/**
+ * Stops TC4, discards all virtual timers and gives TC4 back to the ZeroTC45
+ * object so startTc4 can be used again.
+ */
+template <class Backend>
+void ZeroTC45BasicScheduler<Backend>::end() {
+    timer.stopTc4();
+    timer.setTc4Callback(NULL);
+    instance = NULL;
+
+    // No timer is running until begin is called again, so none can be stopped.
+    clearSlots();
+    freeCount = 0;
+}
+
+/**
+ * Start a virtual timer. The callback is called from the TC4 interrupt
+ * handler period ticks from now, and then every period ticks unless
+ * oneShot is true.
+ *
+ * Periodic timers are rescheduled from their previous deadline, not from
+ * when the callback ran, so they do not drift.
+ *
+ * This may be called from a timer callback.
+ *
+ * @param period The number of ticks until the timer expires, between 1 and 2^31 - 1.
+ * @param callback The function to call when the timer expires.
+ * @param oneShot If true the timer is stopped after the first callback.
+ * @return The id of the timer, or INVALID_TIMER if the arguments are not valid or all timers are in use.
+ */
+template <class Backend>
+typename ZeroTC45BasicScheduler<Backend>::TimerId ZeroTC45BasicScheduler<Backend>::startTimer(uint32_t period, voidFuncPtr callback, boolean oneShot) {
+    if (period == 0 || period > 0x7FFFFFFF || callback == NULL) {
+        return INVALID_TIMER;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (freeCount == 0) {
+        __set_PRIMASK(primask);
+        return INVALID_TIMER;
+    }
+
+    uint8_t slot = freeSlots[--freeCount];
+    Timer& t = timers[slot];
+    t.deadline = timer.getTc4Ticks() + period;
+    t.period = oneShot ? 0 : period;
+    t.callback = callback;
+
+    insert(slot);
+
+    // Only the earliest deadline is programmed into the TC, by handleDeadline if this is from a callback.
+    if (heap[0] == slot && ! expiring) {
+        arm();
+    }
+
+    __set_PRIMASK(primask);
+    return slot;
+}
+
+/**
+ * Stop a virtual timer. The timer id may be given to a new timer after this
+ * so it should not be used again.
+ *
+ * @param id The timer to stop.
+ * @return true if the timer was stopped, false if it was not running.
+ */
+template <class Backend>
+boolean ZeroTC45BasicScheduler<Backend>::stopTimer(TimerId id) {
+    if (id < 0 || id >= MAX_TIMERS) {
+        return false;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    // A slot is only queued if it is in the heap, so a stale index can't make remove run past it.
+    uint8_t heapIndex = timers[id].heapIndex;
+    if (heapIndex >= heapSize) {
+        __set_PRIMASK(primask);
+        return false;
+    }
+
+    remove(heapIndex);
+    freeSlots[freeCount++] = id;
+
+    if (heapIndex == 0 && ! expiring) {
+        arm();
+    }
+
+    __set_PRIMASK(primask);
+    return true;
+}
+
+/**
+ * @param id The timer to check.
+ * @return true if the timer is running. A one-shot timer stops running just before its callback is called.
+ */
+template <class Backend>
+boolean ZeroTC45BasicScheduler<Backend>::isRunning(TimerId id) {
+    if (id < 0 || id >= MAX_TIMERS) {
+        return false;
+    }
+
+    return timers[id].heapIndex < heapSize;
+}
+
+/**
+ * Returns the scheduler time. This is a 32-bit count of ticks since begin was
+ * called and wraps around, so compare times by subtracting them.
+ */
+template <class Backend>
+uint32_t ZeroTC45BasicScheduler<Backend>::now() {
+    return timer.getTc4Ticks();
+}
+
+/**
+ * The TC4 callback, called when the deadline of the earliest timer is reached.
+ * Timers started and stopped by the callbacks don't arm the TC themselves,
+ * so the compare register is written once, after all of them have run.
+ */
+template <class Backend>
+void ZeroTC45BasicScheduler<Backend>::handleDeadline() {
+    ZeroTC45BasicScheduler* scheduler = instance;
+    if (scheduler != NULL) {
+        scheduler->expiring = true;
+        scheduler->runExpired();
+        scheduler->expiring = false;
+
+        // A callback may have called end, which leaves nothing to arm.
+        if (instance == scheduler) {
+            scheduler->arm();
+        }
+    }
+}
+
+/**
+ * Empty the heap and mark every slot as not queued, as they are before
+ * begin and after end.
+ */
+template <class Backend>
+void ZeroTC45BasicScheduler<Backend>::clearSlots() {
+    heapSize = 0;
+    for (uint8_t i = 0; i < MAX_TIMERS; i++) {
+        timers[i].heapIndex = NOT_QUEUED;
+    }
+}
+
+/**
+ * Set the TC4 deadline to the deadline of the earliest timer, or clear it
+ * if there are no timers.
+ *
+ * Must be called with interrupts disabled.
+ */
+template <class Backend>
+void ZeroTC45BasicScheduler<Backend>::arm() {
+    if (heapSize == 0) {
+        timer.clearTc4Deadline();
+    } else {
+        timer.setTc4Deadline(timers[heap[0]].deadline);
+    }
+}
+
+/**
+ * Call the callbacks of all timers whose deadline has passed, rescheduling the
+ * periodic timers and freeing the one-shot timers.
+ */
+template <class Backend>
+void ZeroTC45BasicScheduler<Backend>::runExpired() {
+    while (heapSize > 0) {
+        uint8_t slot = heap[0];
+        Timer& t = timers[slot];
+
+        if ((int32_t)(t.deadline - timer.getTc4Ticks()) > 0) {
+            break;
+        }
+
+        voidFuncPtr callback = t.callback;
+
+        if (t.period != 0) {
+            t.deadline += t.period;
+            siftDown(0);
+        } else {
+            remove(0);
+            freeSlots[freeCount++] = slot;
+        }
+
+        // The heap is consistent again so the callback can start and stop timers.
+        callback();
+    }
+}
+
+template <class Backend>
+void ZeroTC45BasicScheduler<Backend>::insert(uint8_t slot) {
+    place(heapSize, slot);
+    heapSize++;
+    siftUp(heapSize - 1);
+}
+
+template <class Backend>
+void ZeroTC45BasicScheduler<Backend>::remove(uint8_t heapIndex) {
+    timers[heap[heapIndex]].heapIndex = NOT_QUEUED;
+    heapSize--;
+
+    if (heapIndex < heapSize) {
+        // Fill the hole with the last entry and move it to where it belongs.
+        uint8_t moved = heap[heapSize];
+        place(heapIndex, moved);
+        siftDown(heapIndex);
+        siftUp(timers[moved].heapIndex);
+    }
+}
+
+template <class Backend>
+void ZeroTC45BasicScheduler<Backend>::siftUp(uint8_t heapIndex) {
+    uint8_t slot = heap[heapIndex];
+
+    while (heapIndex > 0) {
+        uint8_t parent = (heapIndex - 1) / 2;
+        if ( ! before(slot, heap[parent])) {
+            break;
+        }
+
+        place(heapIndex, heap[parent]);
+        heapIndex = parent;
+    }
+
+    place(heapIndex, slot);
+}
+
+template <class Backend>
+void ZeroTC45BasicScheduler<Backend>::siftDown(uint8_t heapIndex) {
+    uint8_t slot = heap[heapIndex];
+
+    while (true) {
+        uint8_t child = 2 * heapIndex + 1;
+        if (child >= heapSize) {
+            break;
+        }
+
+        if (child + 1 < heapSize && before(heap[child + 1], heap[child])) {
+            child++;
+        }
+
+        if ( ! before(heap[child], slot)) {
+            break;
+        }
+
+        place(heapIndex, heap[child]);
+        heapIndex = child;
+    }
+
+    place(heapIndex, slot);
+}
+
+template <class Backend>
+void ZeroTC45BasicScheduler<Backend>::place(uint8_t heapIndex, uint8_t slot) {
+    heap[heapIndex] = slot;
+    timers[slot].heapIndex = heapIndex;
+}
+
+// Deadlines wrap around so compare them by the sign of their difference.
+template <class Backend>
+boolean ZeroTC45BasicScheduler<Backend>::before(uint8_t slotA, uint8_t slotB) {
+    return (int32_t)(timers[slotA].deadline - timers[slotB].deadline) < 0;
+}
+
+#if defined(ARDUINO_ARCH_SAMD)
+#include "ZeroTC45.h"
+
+typedef ZeroTC45BasicScheduler<ZeroTC45> ZeroTC45Scheduler;
+#endif
+
+#endif
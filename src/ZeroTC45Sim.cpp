@@ -0,0 +1,180 @@
+/*
+  ZeroTC45 library for Arduino Zero and similar.
+
+  Copyright (c) 2020 David Taylor. All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 3.0 of the License, or (at your option) any later version.
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "ZeroTC45Sim.h"
+
+ZeroTC45Sim::ZeroTC45Sim() : time(0), fires(0), deadlineWrites(0) {
+    SimTc stopped = { false, false, 0, 0, NULL };
+    tc4 = stopped;
+    tc5 = stopped;
+}
+
+void ZeroTC45Sim::stopTc4() {
+    tc4.running = false;
+    tc4.armed = false;
+}
+
+void ZeroTC45Sim::stopTc5() {
+    tc5.running = false;
+    tc5.armed = false;
+}
+
+void ZeroTC45Sim::setTc4Callback(voidFuncPtr callback) {
+    tc4.callback = callback;
+}
+
+void ZeroTC45Sim::setTc5Callback(voidFuncPtr callback) {
+    tc5.callback = callback;
+}
+
+void ZeroTC45Sim::startTc4Tickless() {
+    tc4.running = true;
+    tc4.armed = false;
+    tc4.start = time;
+}
+
+void ZeroTC45Sim::startTc5Tickless() {
+    tc5.running = true;
+    tc5.armed = false;
+    tc5.start = time;
+}
+
+uint32_t ZeroTC45Sim::getTc4Ticks() {
+    return ticks(tc4);
+}
+
+uint32_t ZeroTC45Sim::getTc5Ticks() {
+    return ticks(tc5);
+}
+
+void ZeroTC45Sim::setTc4Deadline(uint32_t deadline) {
+    setDeadline(tc4, deadline);
+}
+
+void ZeroTC45Sim::setTc5Deadline(uint32_t deadline) {
+    setDeadline(tc5, deadline);
+}
+
+void ZeroTC45Sim::clearTc4Deadline() {
+    tc4.armed = false;
+}
+
+void ZeroTC45Sim::clearTc5Deadline() {
+    tc5.armed = false;
+}
+
+/**
+ * Move virtual time forward. Each deadline reached is handled in turn: time
+ * is moved to the deadline, the deadline is cleared and the callback is
+ * called, so a callback sees the time it was due at and may set the next
+ * deadline, which is handled in the same call if it is also reached.
+ *
+ * @param ticks The number of ticks to move forward.
+ */
+void ZeroTC45Sim::advance(uint32_t ticks) {
+    uint64_t end = time + ticks;
+    uint64_t when;
+
+    while (SimTc* tc = nextDeadline(end, when)) {
+        time = when;
+        tc->armed = false;
+        fires++;
+        if (tc->callback != NULL) {
+            tc->callback();
+        }
+    }
+
+    time = end;
+}
+
+/**
+ * Move virtual time to the earliest deadline and call its callback.
+ *
+ * @return false if there is no deadline set, and time didn't move.
+ */
+boolean ZeroTC45Sim::advanceToDeadline() {
+    uint64_t when;
+    SimTc* tc = nextDeadline(UINT64_MAX, when);
+    if (tc == NULL) {
+        return false;
+    }
+
+    advance((uint32_t)(when - time));
+    return true;
+}
+
+uint64_t ZeroTC45Sim::now() {
+    return time;
+}
+
+uint32_t ZeroTC45Sim::getFires() {
+    return fires;
+}
+
+uint32_t ZeroTC45Sim::getDeadlineWrites() {
+    return deadlineWrites;
+}
+
+uint32_t ZeroTC45Sim::ticks(const SimTc& tc) {
+    return tc.running ? (uint32_t)(time - tc.start) : 0;
+}
+
+/**
+ * Set the deadline of a simulated TC. As on the board, a deadline that has
+ * already passed, by the sign of the 32-bit difference, is due straight away.
+ */
+void ZeroTC45Sim::setDeadline(SimTc& tc, uint32_t deadline) {
+    if ( ! tc.running) {
+        return;
+    }
+
+    tc.deadline = deadline;
+    tc.armed = true;
+    deadlineWrites++;
+}
+
+/**
+ * Find the simulated TC with the earliest deadline no later than limit. TC4
+ * goes first when both are due at the same time.
+ *
+ * @param limit The latest virtual time to look up to.
+ * @param when Set to the virtual time of the deadline.
+ * @return The TC, or NULL if there is no deadline by limit.
+ */
+ZeroTC45Sim::SimTc* ZeroTC45Sim::nextDeadline(uint64_t limit, uint64_t& when) {
+    SimTc* next = NULL;
+    SimTc* tcs[] = { &tc4, &tc5 };
+
+    for (uint8_t i = 0; i < 2; i++) {
+        SimTc* tc = tcs[i];
+        if ( ! tc->armed) {
+            continue;
+        }
+
+        int32_t remaining = (int32_t)(tc->deadline - ticks(*tc));
+        uint64_t due = (remaining > 0) ? time + remaining : time;
+
+        if (due <= limit && (next == NULL || due < when)) {
+            next = tc;
+            when = due;
+        }
+    }
+
+    return next;
+}
@@ -0,0 +1,110 @@
+/*
+  ZeroTC45 library for Arduino Zero and similar.
+
+  Copyright (c) 2020 David Taylor. All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 3.0 of the License, or (at your option) any later version.
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef ZERO_TC45_SIM_H
+#define ZERO_TC45_SIM_H
+
+#include "ZeroTC45Hal.h"
+
+/**
+ * A simulated timer with the tickless API of ZeroTC45, for running the
+ * scheduling code, eg ZeroTC45BasicScheduler, against virtual time. It
+ * touches no registers, so it builds on a host computer as well as on the
+ * board, and runs as fast as the code under test allows.
+ *
+ * Time only moves when advance or advanceToDeadline is called. Each callback
+ * is called at exactly its deadline, one at a time and in deadline order, so
+ * a run is the same every time.
+ */
+class ZeroTC45Sim {
+
+public:
+    ZeroTC45Sim();
+
+    /// Stop the simulated TC4 counting and cancel its deadline.
+    void stopTc4();
+
+    /// Stop the simulated TC5 counting and cancel its deadline.
+    void stopTc5();
+
+    /// Set the function called at the TC4 deadline.
+    void setTc4Callback(voidFuncPtr callback);
+
+    /// Set the function called at the TC5 deadline.
+    void setTc5Callback(voidFuncPtr callback);
+
+    /// Start the simulated TC4 counting from the current virtual time, from zero.
+    void startTc4Tickless();
+
+    /// Start the simulated TC5 counting from the current virtual time, from zero.
+    void startTc5Tickless();
+
+    /// Returns the simulated TC4 tick count.
+    uint32_t getTc4Ticks();
+
+    /// Returns the simulated TC5 tick count.
+    uint32_t getTc5Ticks();
+
+    /// Call the TC4 callback once, when the TC4 tick count reaches deadline.
+    void setTc4Deadline(uint32_t deadline);
+
+    /// Call the TC5 callback once, when the TC5 tick count reaches deadline.
+    void setTc5Deadline(uint32_t deadline);
+
+    /// Cancel the TC4 deadline.
+    void clearTc4Deadline();
+
+    /// Cancel the TC5 deadline.
+    void clearTc5Deadline();
+
+    /// Move virtual time forward by ticks, calling the callbacks of the deadlines reached on the way.
+    void advance(uint32_t ticks);
+
+    /// Move virtual time to the next deadline and call its callback. Returns false if there is no deadline.
+    boolean advanceToDeadline();
+
+    /// Returns the virtual time in ticks since the simulation was created. It never wraps.
+    uint64_t now();
+
+    /// Returns the number of callbacks called.
+    uint32_t getFires();
+
+    /// Returns the number of times a deadline was set, each of which is a compare register write on the board.
+    uint32_t getDeadlineWrites();
+
+private:
+    struct SimTc {
+        boolean running;
+        boolean armed;
+        uint64_t start;         // The virtual time the count started at.
+        uint32_t deadline;
+        voidFuncPtr callback;
+    };
+
+    uint32_t ticks(const SimTc& tc);
+    void setDeadline(SimTc& tc, uint32_t deadline);
+    SimTc* nextDeadline(uint64_t limit, uint64_t& when);
+
+    SimTc tc4;
+    SimTc tc5;
+    uint64_t time;
+    uint32_t fires;
+    uint32_t deadlineWrites;
+};
+#endif
@@ -0,0 +1,29 @@
+/*
+  ZeroTC45 library for Arduino Zero and similar.
+
+  Copyright (c) 2020 David Taylor. All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 3.0 of the License, or (at your option) any later version.
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+// The state and interrupt handler of ZeroTC45Timer<ZeroTC45Tcc0>. Being in a
+// file of their own, they are only linked into sketches that use TCC0.
+
+#include "ZeroTC45Timer.h"
+
+ZeroTC45TimerState ZeroTC45Tcc0::state = { NULL, NULL, NULL, 0, 0, false };
+
+void TCC0_Handler() {
+    ZeroTC45Timer<ZeroTC45Tcc0>::handleInterrupt();
+}
@@ -0,0 +1,254 @@
+/*
+  ZeroTC45 library for Arduino Zero and similar.
+
+  Copyright (c) 2020 David Taylor. All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 3.0 of the License, or (at your option) any later version.
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "ZeroTC45Timer.h"
+
+// Wait until the last synchronised write to a TC has reached it.
+static inline void waitSync(Tc* tc) {
+    while (tc->COUNT16.STATUS.bit.SYNCBUSY);
+}
+
+/**
+ * Configure a TC in 16-bit MFRQ mode with CC0 as TOP and start it counting
+ * from zero. This is used for TC4 and TC5 by configureTC as well as for TC3.
+ *
+ * Writes to CTRLA, CTRLB, CTRLC, READREQ, COUNT and CC0 are synchronised to
+ * the slow TC clock, which takes several TC clocks, about 5ms each from a
+ * 1024Hz clock. A write made while an earlier one is still being
+ * synchronised stalls the bus until the earlier one is done, holding off
+ * every interrupt, so each synchronised write is preceded by waitSync, which
+ * polls with interrupts enabled. Writes whose value wouldn't change are
+ * skipped, so the TC is only disabled if it is enabled and CTRLA is only
+ * written if the configuration changes.
+ *
+ * If the TC is already enabled with the same CTRLA configuration (eg it was
+ * stopped, or is a finished one-shot) it isn't disabled at all and the
+ * counter is restarted with a retrigger command.
+ *
+ * @param tc The TC to configure.
+ * @param prescaler The TC prescaler setting.
+ * @param top The last count of each period.
+ * @param oneShot If true the TC stops at the first overflow.
+ * @param interrupt If true the overflow interrupt is enabled.
+ * @param lastTop The CC0 value last written, which can't be read without a read request, or NULL to always write CC0.
+ * @param hold If true leave the TC stopped, or disabled, with everything else set up.
+ * @param wait If true wait until the write that starts the TC has reached it.
+ */
+void ZeroTC45TimerRegisters::configure(Tc* tc, uint8_t prescaler, uint32_t top, boolean oneShot, boolean interrupt,
+                                       uint16_t* lastTop, boolean hold, boolean wait) {
+    uint16_t ctrla = TC_CTRLA_MODE_COUNT16        // Use 16-bit counting mode.
+                   | TC_CTRLA_WAVEGEN(1)          // Use MFRQ mode so CC0 is 'TOP' and we get an overflow every time CC0 is reached.
+                   | TC_CTRLA_RUNSTDBY            // Run when in standby mode.
+                   | TC_CTRLA_PRESCALER(prescaler);
+
+    uint16_t current = tc->COUNT16.CTRLA.reg;
+    boolean restart = (current & TC_CTRLA_ENABLE) && (current & ~TC_CTRLA_ENABLE) == ctrla;
+
+    if ( ! restart) {
+        // Disable TC so it can be configured. The other CTRLA fields can only be changed once it is disabled.
+        if (current & TC_CTRLA_ENABLE) {
+            waitSync(tc);
+            tc->COUNT16.CTRLA.reg = current & ~TC_CTRLA_ENABLE;
+        }
+
+        if ((current & ~TC_CTRLA_ENABLE) != ctrla) {
+            waitSync(tc);
+            tc->COUNT16.CTRLA.reg = ctrla;
+        }
+
+        // Disabling doesn't clear the count, and enabling starts from it.
+        waitSync(tc);
+        tc->COUNT16.COUNT.reg = 0;
+    } else if (hold) {
+        // A running TC would carry on with the new period before it is restarted.
+        waitSync(tc);
+        tc->COUNT16.CTRLBSET.reg = TC_CTRLBSET_CMD_STOP;
+    }
+
+    // Enable overflow interrupts if there is a callback, and no others in case the TC was in tickless mode.
+    // The interrupt registers are not synchronised.
+    tc->COUNT16.INTENCLR.reg = TC_INTENCLR_MC0 | TC_INTENCLR_MC1;
+    setInterrupt(tc, interrupt);
+
+    // In MFRQ mode, one-shot works and will only generate one overflow interrupt.
+    // CTRLB can be read without synchronisation so only write it if it changes.
+    if (tc->COUNT16.CTRLBSET.bit.ONESHOT != oneShot) {
+        waitSync(tc);
+        if (oneShot) {
+            tc->COUNT16.CTRLBSET.reg = TC_CTRLBSET_ONESHOT;
+        } else {
+            tc->COUNT16.CTRLBCLR.reg = TC_CTRLBCLR_ONESHOT;
+        }
+    }
+
+    // Set the compare channel 0 value. In MFRQ mode this is used as 'TOP' to see when overflow occurs.
+    if ( ! restart || lastTop == NULL || *lastTop != top) {
+        waitSync(tc);
+        tc->COUNT16.CC[0].reg = top;
+        if (lastTop != NULL) {
+            *lastTop = top;
+        }
+    }
+
+    // Keep the count synchronised so it can be read without waiting for a read request.
+    uint16_t readreq = TC_READREQ_RCONT | TC_READREQ_ADDR(TC_COUNT16_COUNT_OFFSET);
+    if (tc->COUNT16.READREQ.reg != readreq) {
+        waitSync(tc);
+        tc->COUNT16.READREQ.reg = readreq;
+    }
+
+    if (hold) {
+        // Left for the caller to start.
+    } else if (restart) {
+        // Start counting from zero again.
+        waitSync(tc);
+        tc->COUNT16.CTRLBSET.reg = TC_CTRLBSET_CMD_RETRIGGER;
+    } else {
+        waitSync(tc);
+        tc->COUNT16.CTRLA.reg = ctrla | TC_CTRLA_ENABLE;
+    }
+
+    if (wait) {
+        waitSync(tc);
+    }
+}
+
+/**
+ * Configure a TCC in normal frequency mode with PER as TOP and start it
+ * counting from zero. Unlike the TCs each TCC register has its own
+ * synchronisation busy bit.
+ *
+ * @param tcc The TCC to configure.
+ * @param prescaler The TCC prescaler setting, with the same values as the TC one.
+ * @param top The last count of each period.
+ * @param oneShot If true the TCC stops at the first overflow.
+ * @param interrupt If true the overflow interrupt is enabled.
+ */
+void ZeroTC45TimerRegisters::configure(Tcc* tcc, uint8_t prescaler, uint32_t top, boolean oneShot, boolean interrupt) {
+    // CTRLA can only be changed while the TCC is disabled.
+    tcc->CTRLA.reg &= ~TCC_CTRLA_ENABLE;
+    while (tcc->SYNCBUSY.reg & TCC_SYNCBUSY_ENABLE);
+
+    tcc->CTRLA.reg = TCC_CTRLA_PRESCALER(prescaler) | TCC_CTRLA_RUNSTDBY;
+
+    tcc->WAVE.reg = TCC_WAVE_WAVEGEN_NFRQ;
+    while (tcc->SYNCBUSY.reg & TCC_SYNCBUSY_WAVE);
+
+    tcc->PER.reg = top;
+    while (tcc->SYNCBUSY.reg & TCC_SYNCBUSY_PER);
+
+    tcc->COUNT.reg = 0;
+    while (tcc->SYNCBUSY.reg & TCC_SYNCBUSY_COUNT);
+
+    if (oneShot) {
+        tcc->CTRLBSET.reg = TCC_CTRLBSET_ONESHOT;
+    } else {
+        tcc->CTRLBCLR.reg = TCC_CTRLBCLR_ONESHOT;
+    }
+    while (tcc->SYNCBUSY.reg & TCC_SYNCBUSY_CTRLB);
+
+    // The interrupt registers are not synchronised.
+    tcc->INTENCLR.reg = TCC_INTENCLR_MASK;
+    tcc->INTFLAG.reg = TCC_INTFLAG_OVF;
+    if (interrupt) {
+        tcc->INTENSET.reg = TCC_INTENSET_OVF;
+    }
+
+    tcc->CTRLA.reg |= TCC_CTRLA_ENABLE;
+    while (tcc->SYNCBUSY.reg & TCC_SYNCBUSY_ENABLE);
+}
+
+/**
+ * Enable or disable the overflow interrupt, clearing any overflow already
+ * flagged so it doesn't call a callback set while the timer runs straight away.
+ */
+void ZeroTC45TimerRegisters::setInterrupt(Tc* tc, boolean interrupt) {
+    tc->COUNT16.INTFLAG.reg = TC_INTFLAG_OVF;
+    if (interrupt) {
+        tc->COUNT16.INTENSET.reg = TC_INTENSET_OVF;
+    } else {
+        tc->COUNT16.INTENCLR.reg = TC_INTENCLR_OVF;
+    }
+}
+
+void ZeroTC45TimerRegisters::setInterrupt(Tcc* tcc, boolean interrupt) {
+    tcc->INTFLAG.reg = TCC_INTFLAG_OVF;
+    if (interrupt) {
+        tcc->INTENSET.reg = TCC_INTENSET_OVF;
+    } else {
+        tcc->INTENCLR.reg = TCC_INTENCLR_OVF;
+    }
+}
+
+void ZeroTC45TimerRegisters::disableInterrupts(Tc* tc) {
+    tc->COUNT16.INTENCLR.reg = TC_INTENCLR_OVF | TC_INTENCLR_MC0 | TC_INTENCLR_MC1;
+}
+
+void ZeroTC45TimerRegisters::disableInterrupts(Tcc* tcc) {
+    tcc->INTENCLR.reg = TCC_INTENCLR_MASK;
+}
+
+/**
+ * Stop a TC, as stopTC does for TC4 and TC5. Its interrupts should be
+ * disabled first so none is taken while the command is synchronised.
+ */
+void ZeroTC45TimerRegisters::stop(Tc* tc) {
+    waitSync(tc);
+    tc->COUNT16.CTRLBSET.reg = TC_CTRLBSET_CMD_STOP;
+}
+
+void ZeroTC45TimerRegisters::stop(Tcc* tcc) {
+    while (tcc->SYNCBUSY.reg & TCC_SYNCBUSY_CTRLB);
+    tcc->CTRLBSET.reg = TCC_CTRLBSET_CMD_STOP;
+}
+
+void ZeroTC45TimerRegisters::retrigger(Tc* tc) {
+    waitSync(tc);
+    tc->COUNT16.CTRLBSET.reg = TC_CTRLBSET_CMD_RETRIGGER;
+}
+
+void ZeroTC45TimerRegisters::retrigger(Tcc* tcc) {
+    while (tcc->SYNCBUSY.reg & TCC_SYNCBUSY_CTRLB);
+    tcc->CTRLBSET.reg = TCC_CTRLBSET_CMD_RETRIGGER;
+}
+
+/**
+ * Clear the overflow flag with a single write, as the TC4 and TC5 handlers
+ * do, so an overflow during the callback sets it again.
+ *
+ * @return true if the TC had overflowed.
+ */
+boolean ZeroTC45TimerRegisters::clearOverflow(Tc* tc) {
+    if (tc->COUNT16.INTFLAG.reg & TC_INTFLAG_OVF) {
+        tc->COUNT16.INTFLAG.reg = TC_INTFLAG_OVF;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @return true if the TCC had overflowed.
+ */
+boolean ZeroTC45TimerRegisters::clearOverflow(Tcc* tcc) {
+    if (tcc->INTFLAG.reg & TCC_INTFLAG_OVF) {
+        tcc->INTFLAG.reg = TCC_INTFLAG_OVF;
+        return true;
+    }
+    return false;
+}
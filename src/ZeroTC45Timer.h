@@ -0,0 +1,258 @@
+/*
+  ZeroTC45 library for Arduino Zero and similar.
+
+  Copyright (c) 2020 David Taylor. All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 3.0 of the License, or (at your option) any later version.
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef ZERO_TC45_TIMER_H
+#define ZERO_TC45_TIMER_H
+
+#include "ZeroTC45.h"
+
+/// The state of a ZeroTC45Timer, one per timer.
+struct ZeroTC45TimerState {
+    voidFuncPtr function;
+    contextFuncPtr contextFunction;
+    void* context;
+    uint8_t prescaler;
+    uint8_t priority;
+    volatile boolean running;       // True from start until stop, so setCallback knows to change the interrupt.
+};
+
+/*
+ * Descriptors of the timers ZeroTC45Timer can use as well as TC4 and TC5.
+ * Each one gives the registers, interrupt, generic clock and power manager
+ * bit of its peripheral, so all of these are known at compile time.
+ *
+ * The state of each timer is defined with its interrupt handler, in a file
+ * of its own, eg ZeroTC45Tc3.cpp. The library is linked as an archive, so a
+ * handler is only linked into sketches that use its timer, and the other
+ * timers are left for eg Servo and tone().
+ */
+
+/// TC3, a 16-bit TC. It shares its generic clock with TCC2.
+struct ZeroTC45Tc3 {
+    static Tc* hw() { return TC3; }
+    static const IRQn_Type irq = TC3_IRQn;
+    static const uint8_t clockId = GCM_TCC2_TC3;
+    static const uint32_t apbMask = PM_APBCMASK_TC3;
+    static const uint32_t maxTicks = 0x10000;
+    static ZeroTC45TimerState state;
+};
+
+/// TCC0, a 24-bit TCC. It shares its generic clock with TCC1.
+struct ZeroTC45Tcc0 {
+    static Tcc* hw() { return TCC0; }
+    static const IRQn_Type irq = TCC0_IRQn;
+    static const uint8_t clockId = GCM_TCC0_TCC1;
+    static const uint32_t apbMask = PM_APBCMASK_TCC0;
+    static const uint32_t maxTicks = 0x1000000;
+    static ZeroTC45TimerState state;
+};
+
+/// TCC1, a 24-bit TCC. It shares its generic clock with TCC0.
+struct ZeroTC45Tcc1 {
+    static Tcc* hw() { return TCC1; }
+    static const IRQn_Type irq = TCC1_IRQn;
+    static const uint8_t clockId = GCM_TCC0_TCC1;
+    static const uint32_t apbMask = PM_APBCMASK_TCC1;
+    static const uint32_t maxTicks = 0x1000000;
+    static ZeroTC45TimerState state;
+};
+
+/// TCC2, a 16-bit TCC. It shares its generic clock with TC3.
+struct ZeroTC45Tcc2 {
+    static Tcc* hw() { return TCC2; }
+    static const IRQn_Type irq = TCC2_IRQn;
+    static const uint8_t clockId = GCM_TCC2_TC3;
+    static const uint32_t apbMask = PM_APBCMASK_TCC2;
+    static const uint32_t maxTicks = 0x10000;
+    static ZeroTC45TimerState state;
+};
+
+/**
+ * The register writes for each kind of peripheral. The TC and TCC versions
+ * are overloads picked by the type of the descriptor's hw(), so there is no
+ * test of the kind of timer at run time. The TC versions are also the ones
+ * ZeroTC45 uses for TC4 and TC5.
+ */
+class ZeroTC45TimerRegisters {
+
+public:
+    /// Set up a TC as a periodic or one-shot timer, writing only what changes. top caches the CC0 value, or is NULL to always write it.
+    static void configure(Tc* tc, uint8_t prescaler, uint32_t top, boolean oneShot, boolean interrupt,
+                          uint16_t* lastTop = NULL, boolean hold = false, boolean wait = true);
+    static void configure(Tcc* tcc, uint8_t prescaler, uint32_t top, boolean oneShot, boolean interrupt);
+
+    /// Enable or disable the overflow interrupt of a running timer.
+    static void setInterrupt(Tc* tc, boolean interrupt);
+    static void setInterrupt(Tcc* tcc, boolean interrupt);
+
+    /// Disable all the interrupts of a timer. The interrupt registers are not synchronised, so this takes effect straight away.
+    static void disableInterrupts(Tc* tc);
+    static void disableInterrupts(Tcc* tcc);
+
+    static void stop(Tc* tc);
+    static void stop(Tcc* tcc);
+    static void retrigger(Tc* tc);
+    static void retrigger(Tcc* tcc);
+    static boolean clearOverflow(Tc* tc);
+    static boolean clearOverflow(Tcc* tcc);
+};
+
+/**
+ * Runs TC3 or one of the TCCs with the same start, stop and callback API as
+ * TC4 and TC5, for more periodic timers in hardware, eg
+ *
+ *     ZeroTC45Timer<ZeroTC45Tc3>::begin(timer);
+ *     ZeroTC45Timer<ZeroTC45Tc3>::setCallback(tc3Callback);
+ *     ZeroTC45Timer<ZeroTC45Tc3>::start(100);
+ *
+ * The timer is a template argument so each one has its own state and its
+ * registers are known at compile time. The periods are in ticks of its clock
+ * configuration, so the CRYSTAL_MILLISECONDS scaling and the other TC4 and
+ * TC5 features are not available.
+ */
+template <class Timer>
+class ZeroTC45Timer {
+
+public:
+    /// Clock the timer from the GCLK set up by timer.begin, at the TC4 tick rate. timer.begin must be called first.
+    static void begin(ZeroTC45& timer) {
+        begin(timer, timer.getClockConfig());
+    }
+
+    /**
+     * Clock the timer from the GCLK set up by timer.begin with its own
+     * prescaler. The generic clock is shared with the peripheral named in the
+     * descriptor, so that one also runs from the ZeroTC45 GCLK afterwards.
+     *
+     * @param timer The ZeroTC45 object whose GCLK is used. Its begin must be called first.
+     * @param config The tick rate, which must have the same source and GCLK divisor as that of TC4.
+     * @return true if the timer was set up, false if config can't be made from the GCLK.
+     */
+    static boolean begin(ZeroTC45& timer, ZeroTC45::ClockConfig config) {
+        ZeroTC45::ClockConfig shared = timer.getClockConfig();
+        if (config.source != shared.source || config.gclkDivisor != shared.gclkDivisor) {
+            return false;
+        }
+
+        stop();
+        Timer::state.prescaler = config.prescaler;
+
+        PM->APBCMASK.reg |= Timer::apbMask;
+
+        GCLK->CLKCTRL.reg = GCLK_CLKCTRL_CLKEN
+                          | GCLK_CLKCTRL_GEN(timer.getGclkId())
+                          | GCLK_CLKCTRL_ID(Timer::clockId);
+        while (GCLK->STATUS.bit.SYNCBUSY);
+
+        return true;
+    }
+
+    /// Set the function called from the interrupt each time the timer fires, or NULL for none. This can be done while the timer runs.
+    static void setCallback(voidFuncPtr callback) {
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        Timer::state.function = callback;
+        Timer::state.contextFunction = NULL;
+        updateInterrupt();
+        __set_PRIMASK(primask);
+    }
+
+    /// Set a function called with context each time the timer fires.
+    static void setCallback(contextFuncPtr callback, void* context) {
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        Timer::state.function = NULL;
+        Timer::state.contextFunction = callback;
+        Timer::state.context = context;
+        updateInterrupt();
+        __set_PRIMASK(primask);
+    }
+
+    /**
+     * Set the NVIC priority of the timer interrupt. The default is 0, the
+     * highest. See ZeroTC45::setTc4Priority.
+     *
+     * @param priority 0 (highest) - 3 (lowest).
+     */
+    static void setPriority(uint8_t priority) {
+        Timer::state.priority = (priority > 3) ? 3 : priority;
+        NVIC_SetPriority(Timer::irq, Timer::state.priority);
+    }
+
+    /**
+     * Start the timer, firing every period ticks, or once if oneShot is true.
+     * Restarting a running timer starts a new period from now.
+     *
+     * @param period The ticks between fires, from 1 to maxTicks of the descriptor.
+     * @param oneShot If true the timer only fires once.
+     */
+    static void start(uint32_t period, boolean oneShot = false) {
+        if (period == 0) {
+            period = 1;
+        } else if (period > Timer::maxTicks) {
+            period = Timer::maxTicks;
+        }
+
+        // The overflow is on the count after TOP, so TOP is one less than the period.
+        ZeroTC45TimerRegisters::configure(Timer::hw(), Timer::state.prescaler, period - 1, oneShot, hasCallback());
+        Timer::state.running = true;
+
+        NVIC_ClearPendingIRQ(Timer::irq);
+        NVIC_SetPriority(Timer::irq, Timer::state.priority);
+        NVIC_EnableIRQ(Timer::irq);
+    }
+
+    /// Stop the timer. No callback is called after this returns.
+    static void stop() {
+        Timer::state.running = false;
+        ZeroTC45TimerRegisters::disableInterrupts(Timer::hw());
+        ZeroTC45TimerRegisters::stop(Timer::hw());
+        NVIC_DisableIRQ(Timer::irq);
+        NVIC_ClearPendingIRQ(Timer::irq);
+    }
+
+    /// Start the current period again from zero, or restart a finished one-shot.
+    static void retrigger() {
+        ZeroTC45TimerRegisters::retrigger(Timer::hw());
+    }
+
+    /// Called from the interrupt handler of the timer.
+    static void handleInterrupt() {
+        if (ZeroTC45TimerRegisters::clearOverflow(Timer::hw())) {
+            if (Timer::state.contextFunction != NULL) {
+                Timer::state.contextFunction(Timer::state.context);
+            } else if (Timer::state.function != NULL) {
+                Timer::state.function();
+            }
+        }
+    }
+
+private:
+    static boolean hasCallback() {
+        return Timer::state.function != NULL || Timer::state.contextFunction != NULL;
+    }
+
+    // Called with interrupts disabled. The overflow interrupt is only enabled while there is a callback.
+    static void updateInterrupt() {
+        if (Timer::state.running) {
+            ZeroTC45TimerRegisters::setInterrupt(Timer::hw(), hasCallback());
+        }
+    }
+};
+#endif
@@ -0,0 +1,103 @@
+/*
+  ZeroTC45 library for Arduino Zero and similar.
+
+  Copyright (c) 2020 David Taylor. All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 3.0 of the License, or (at your option) any later version.
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "ZeroTC45Timestamp.h"
+
+/**
+ * Starts the timestamp clock. TC5 is started in tickless mode with no
+ * deadline, so it only interrupts twice per pass of its 16-bit count to
+ * extend the count to 64 bits.
+ *
+ * The TC5 clock must be OSCULP32K or XOSC32K, eg from the SECONDS or
+ * CRYSTAL_MILLISECONDS resolution or a tick rate made with tickRate, so the
+ * count carries on in standby, where SysTick and so millis() stop. XOSC32K
+ * is the accurate one.
+ *
+ * @return false if the TC5 clock stops in standby.
+ */
+boolean ZeroTC45Timestamp::begin() {
+    ZeroTC45::ClockConfig config = timer.getTc5ClockConfig();
+    if (config.source != ZeroTC45::OSCULP32K && config.source != ZeroTC45::XOSC32K) {
+        return false;
+    }
+
+    hz = ZeroTC45::tickHz(config);
+
+    timer.stopTc5();
+    timer.setTc5Callback(NULL);
+    timer.startTc5Tickless();
+
+    return true;
+}
+
+/**
+ * Stops TC5 and gives it back to the ZeroTC45 object so startTc5 can be used again.
+ */
+void ZeroTC45Timestamp::end() {
+    timer.stopTc5();
+    hz = 0;
+}
+
+/**
+ * Returns the ticks since begin was called, in ticks of the TC5 clock. At
+ * 1024Hz the 64-bit count would take 570 million years to wrap.
+ *
+ * This doesn't disable interrupts, so it doesn't add latency to them, and
+ * can be called from an interrupt to stamp an event.
+ */
+uint64_t ZeroTC45Timestamp::now() {
+    return timer.getTc5Ticks64();
+}
+
+/**
+ * Returns the microseconds since begin was called.
+ */
+uint64_t ZeroTC45Timestamp::micros() {
+    return toMicros(now());
+}
+
+/**
+ * Returns the milliseconds since begin was called.
+ */
+uint64_t ZeroTC45Timestamp::millis() {
+    return toMicros(now()) / 1000;
+}
+
+/**
+ * Returns the tick rate of the timestamps in Hz, or 0 if begin wasn't successful.
+ */
+uint32_t ZeroTC45Timestamp::tickHz() {
+    return hz;
+}
+
+/**
+ * Convert a number of ticks, eg the difference of two timestamps, to
+ * microseconds. The whole seconds are converted separately so the
+ * multiplication can't overflow.
+ *
+ * @param ticks The number of ticks.
+ * @return The microseconds, rounded down, or 0 if begin wasn't successful.
+ */
+uint64_t ZeroTC45Timestamp::toMicros(uint64_t ticks) {
+    if (hz == 0) {
+        return 0;
+    }
+
+    return (ticks / hz) * 1000000 + (ticks % hz) * 1000000 / hz;
+}
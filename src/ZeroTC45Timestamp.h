@@ -0,0 +1,64 @@
+/*
+  ZeroTC45 library for Arduino Zero and similar.
+
+  Copyright (c) 2020 David Taylor. All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 3.0 of the License, or (at your option) any later version.
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef ZERO_TC45_TIMESTAMP_H
+#define ZERO_TC45_TIMESTAMP_H
+
+#include "ZeroTC45.h"
+
+class ZeroTC45Timestamp {
+
+public:
+    /**
+     * Create a monotonic 64-bit timestamp clock on TC5.
+     *
+     * Only one timestamp clock should be created per sketch, and TC5 cannot
+     * be used through the ZeroTC45 object while it is running. It can run at
+     * the same time as a ZeroTC45Scheduler, which uses TC4.
+     *
+     * @param timer The ZeroTC45 object that owns TC5.
+     */
+    ZeroTC45Timestamp(ZeroTC45& timer) : timer(timer), hz(0) {};
+
+    /// Take over TC5 and start counting from zero. Returns false if the TC5 clock doesn't run in standby.
+    boolean begin();
+
+    /// Stop counting and release TC5.
+    void end();
+
+    /// Returns the ticks since begin. Never wraps, and can be called from an interrupt.
+    uint64_t now();
+
+    /// Returns the microseconds since begin.
+    uint64_t micros();
+
+    /// Returns the milliseconds since begin.
+    uint64_t millis();
+
+    /// Returns the tick rate of the timestamps in Hz.
+    uint32_t tickHz();
+
+    /// Convert a number of ticks to microseconds.
+    uint64_t toMicros(uint64_t ticks);
+
+private:
+    ZeroTC45& timer;
+    uint32_t hz;
+};
+#endif
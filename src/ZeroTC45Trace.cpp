@@ -0,0 +1,158 @@
+/*
+  ZeroTC45 library for Arduino Zero and similar.
+
+  Copyright (c) 2020 David Taylor. All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 3.0 of the License, or (at your option) any later version.
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+
+
+#include "ZeroTC45Trace.h"
+#include "ZeroTC45.h"
+
+// The number of records read at a time by dump, so interrupts are only disabled briefly.
+static const uint8_t DUMP_CHUNK = 8;
+
+static ZeroTC45Trace::Record records[ZEROTC45_TRACE_SIZE];
+static uint16_t head = 0;       // Where the next record is written.
+static uint16_t count = 0;      // The number of records not yet read.
+static uint32_t lost = 0;
+
+static const char* const eventNames[] = { "enter", "exit", "start", "stop", "mark" };
+
+/**
+ * Add a record, overwriting the oldest if the buffer is full. This takes a
+ * few dozen clocks with interrupts disabled, so a higher priority interrupt
+ * can't leave a half written record.
+ *
+ * @param event What happened.
+ * @param source 4 or 5 for the TCs, or a number chosen by the sketch.
+ * @param cycles When it happened, from ZeroTC45::getCycles.
+ */
+void ZeroTC45Trace::record(Event event, uint8_t source, uint32_t cycles) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    Record& r = records[head];
+    r.cycles = cycles;
+    r.event = event;
+    r.source = source;
+    head = (head + 1) & (SIZE - 1);
+
+    if (count < SIZE) {
+        count++;
+    } else {
+        lost++;
+    }
+
+    __set_PRIMASK(primask);
+}
+
+/**
+ * Add a record stamped with ZeroTC45::getCycles.
+ *
+ * @param source A number for what is being traced, other than 4 and 5.
+ * @param event What happened, MARK by default. ENTER and EXIT can be used to trace other interrupt handlers.
+ */
+void ZeroTC45Trace::mark(uint8_t source, Event event) {
+    record(event, source, ZeroTC45::getCycles());
+}
+
+/**
+ * Remove the oldest records, so they are not returned again.
+ *
+ * @param out Where to copy the records.
+ * @param max The most records to copy.
+ * @return The number of records copied.
+ */
+uint16_t ZeroTC45Trace::read(Record* out, uint16_t max) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    uint16_t n = (count < max) ? count : max;
+    uint16_t tail = (head - count) & (SIZE - 1);
+    for (uint16_t i = 0; i < n; i++) {
+        out[i] = records[(tail + i) & (SIZE - 1)];
+    }
+    count -= n;
+
+    __set_PRIMASK(primask);
+    return n;
+}
+
+uint32_t ZeroTC45Trace::getLost() {
+    return lost;
+}
+
+void ZeroTC45Trace::clear() {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    count = 0;
+    lost = 0;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * Print the records, oldest first, with the stamp, the clocks since the
+ * record before, the source and the event, eg
+ *
+ *     1234567890 +    2412 TC4 enter
+ *
+ * Only the records there when it is called are printed, so it returns even
+ * if a fast timer adds records as quickly as they are printed. Those added
+ * while printing are left for the next dump. Any records that were lost are
+ * reported first.
+ *
+ * @param out Where to print, eg Serial.
+ */
+void ZeroTC45Trace::dump(Print& out) {
+    char line[48];
+    Record chunk[DUMP_CHUNK];
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t lostNow = lost;
+    lost = 0;
+    uint16_t remaining = count;
+    __set_PRIMASK(primask);
+
+    if (lostNow != 0) {
+        snprintf(line, sizeof(line), "%lu records lost", (unsigned long)lostNow);
+        out.println(line);
+    }
+
+    boolean first = true;
+    uint32_t previous = 0;
+    uint16_t n;
+    while (remaining != 0 && (n = read(chunk, (remaining < DUMP_CHUNK) ? remaining : DUMP_CHUNK)) != 0) {
+        remaining -= n;
+        for (uint16_t i = 0; i < n; i++) {
+            const Record& r = chunk[i];
+            uint32_t delta = first ? 0 : r.cycles - previous;
+            first = false;
+            previous = r.cycles;
+
+            const char* name = (r.event <= MARK) ? eventNames[r.event] : "?";
+            if (r.source == 4 || r.source == 5) {
+                snprintf(line, sizeof(line), "%10lu +%8lu TC%u %s",
+                         (unsigned long)r.cycles, (unsigned long)delta, r.source, name);
+            } else {
+                snprintf(line, sizeof(line), "%10lu +%8lu #%u %s",
+                         (unsigned long)r.cycles, (unsigned long)delta, r.source, name);
+            }
+            out.println(line);
+        }
+    }
+}
@@ -0,0 +1,86 @@
+/*
+  ZeroTC45 library for Arduino Zero and similar.
+
+  Copyright (c) 2020 David Taylor. All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 3.0 of the License, or (at your option) any later version.
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+
+#ifndef ZERO_TC45_TRACE_H
+#define ZERO_TC45_TRACE_H
+
+#include "Arduino.h"
+
+/// The number of records kept, a power of 2 from 2 to 32768. Like ZEROTC45_TRACE, it must be defined for the whole build to change it.
+#ifndef ZEROTC45_TRACE_SIZE
+#define ZEROTC45_TRACE_SIZE 64
+#endif
+
+#if ZEROTC45_TRACE_SIZE < 2 || (ZEROTC45_TRACE_SIZE & (ZEROTC45_TRACE_SIZE - 1)) != 0 || ZEROTC45_TRACE_SIZE > 32768
+#error "ZEROTC45_TRACE_SIZE must be a power of 2, from 2 to 32768"
+#endif
+
+/**
+ * A ring buffer of time stamped events, for seeing when the timers ran
+ * relative to each other and to other interrupts. When the library is built
+ * with ZEROTC45_TRACE defined, the TC4 and TC5 interrupt handlers record
+ * their entry and exit, and the TCs record when they are started and
+ * stopped. Without it there are no hooks in the library at all.
+ *
+ * The stamps are the CPU clock count of ZeroTC45::getCycles. When the
+ * buffer is full the oldest records are overwritten, so it always holds the
+ * latest events.
+ */
+class ZeroTC45Trace {
+
+public:
+    /// What a record is of.
+    enum Event {
+        ENTER,      ///< An interrupt handler was entered.
+        EXIT,       ///< An interrupt handler returned.
+        START,      ///< A TC was started.
+        STOP,       ///< A TC was stopped.
+        MARK        ///< A point marked by the sketch.
+    };
+
+    /// One event. The source is 4 or 5 for the TCs, or a number chosen by the sketch.
+    struct Record {
+        uint32_t cycles;
+        uint8_t event;
+        uint8_t source;
+    };
+
+    /// The number of records kept.
+    static const uint16_t SIZE = ZEROTC45_TRACE_SIZE;
+
+    /// Add a record with the given stamp. Safe to call from any interrupt handler.
+    static void record(Event event, uint8_t source, uint32_t cycles);
+
+    /// Add a record stamped now, eg from another interrupt handler to see it alongside the timers.
+    static void mark(uint8_t source, Event event = MARK);
+
+    /// Remove up to max of the oldest records into records. Returns the number removed.
+    static uint16_t read(Record* records, uint16_t max);
+
+    /// Returns the number of records overwritten before they were read.
+    static uint32_t getLost();
+
+    /// Remove all records and reset the lost count.
+    static void clear();
+
+    /// Remove the records there now and print them to out, one per line. Records added meanwhile are left for the next dump.
+    static void dump(Print& out);
+};
+#endif